@@ -0,0 +1,42 @@
+#pragma once
+
+#include "stdx/stdxcore.h"
+
+#include <chrono>
+#include <limits>
+#include <algorithm>
+
+namespace bench
+{
+using stdx::uint;
+
+using clock = std::chrono::steady_clock;
+
+// best of reps, in seconds, the minimum filters out scheduling noise
+template<typename f_t>
+double timeit(f_t&& f, uint reps)
+{
+    double best = std::numeric_limits<double>::max();
+    for (uint r = 0; r < std::max(reps, uint(1)); ++r)
+    {
+        auto const start = clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+    }
+
+    return best;
+}
+
+// keeps the optimizer from discarding results that are otherwise unused
+// msvc has no inline assembly on x64, elsewhere the address escaping into a volatile is not enough once the value goes out of scope
+template<typename t>
+void donotoptimize(t const& value)
+{
+#ifdef _MSC_VER
+    static void const* volatile sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r"(&value) : "memory");
+#endif
+}
+}
@@ -0,0 +1,492 @@
+#include "benchutils.h"
+#include "stdx/stdx.h"
+#include "engine/engineutils.h"
+#include "engine/geometry/ffd.h"
+#include "engine/geometry/geocore.h"
+#include "engine/geometry/beziermaths.h"
+#include "engine/geometry/beziermathskernels.h"
+#include "engine/simd.h"
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <limits>
+#include <functional>
+
+// times the bezier evaluation kernels over increasing vertex counts and checks them against a double precision reference
+// usage : softbody_bench_beziermaths [maxverts] [reps]
+
+using namespace beziermaths;
+
+namespace
+{
+using stdx::uint;
+
+// nominal flop counts of each algorithm as written(transcendentals not counted)
+// ns/vertex is what compares kernels, gflops tells how much of the machine a kernel is using
+constexpr double volumeflops(uint n) { return double((n + 1) * (n + 1) * (n + 1)) * 8.0; }
+constexpr double basisflops = 5.0;
+constexpr double normalflops = 25.0;
+constexpr double bulkevalflops = 4.0 * volumeflops(2) + 6.0 * basisflops + normalflops;
+constexpr double bulkevalflopsn(uint n) { return 4.0 * volumeflops(n) + 6.0 * double(4 * n + 2) + normalflops; }
+constexpr double evalfastflops = 4.0 * volumeflops(2) + 6.0 * basisflops + 3.0 * 10.0;
+constexpr double lerpflops = 9.0;
+constexpr double trivariateflops = 39.0 * 5.0 + 27.0 * 6.0 + 9.0 * 6.0 + 3.0 * 6.0;
+
+constexpr double decasteljauvolumeflops(uint n) { double r = 0.0; for (uint m = 1; m <= n; ++m) r += double(m * m * m) * 7.0 * lerpflops; return r; }
+constexpr double decasteljautriangleflops(uint n) { double r = 0.0; for (uint m = 1; m <= n; ++m) r += double(m * (m + 1) / 2) * 15.0; return r; }
+constexpr double decasteljausurfaceflops(uint n) { double r = 0.0; for (uint m = 1; m <= n; ++m) r += double(m * m) * 3.0 * lerpflops; return r; }
+
+constexpr uint accuracysamples = 4096;
+
+using dvec3 = std::array<double, 3>;
+
+double binomial(uint n, uint k)
+{
+    double r = 1.0;
+    for (uint i = 1; i <= k; ++i) r = r * double(n - k + i) / double(i);
+    return r;
+}
+
+double bernstein(uint n, uint i, double t) { return binomial(n, i) * std::pow(1.0 - t, double(n - i)) * std::pow(t, double(i)); }
+
+double dbernstein(uint n, uint i, double t)
+{
+    double const l = i > 0 ? bernstein(n - 1, i - 1, t) : 0.0;
+    double const r = i < n ? bernstein(n - 1, i, t) : 0.0;
+    return double(n) * (l - r);
+}
+
+// control point index is x + (n + 1) * z + (n + 1)^2 * y, the same layout bulkevaluate and ffd_object use
+// d selects the partial derivative(0 = x, 1 = y, 2 = z), -1 evaluates the position
+template<uint n>
+dvec3 refvolume(beziervolume<n> const& v, vector3 const& p, int d = -1)
+{
+    dvec3 r = {};
+    for (uint k = 0; k <= n; ++k)
+        for (uint b = 0; b <= n; ++b)
+            for (uint a = 0; a <= n; ++a)
+            {
+                double const wx = d == 0 ? dbernstein(n, a, p.x) : bernstein(n, a, p.x);
+                double const wy = d == 1 ? dbernstein(n, k, p.y) : bernstein(n, k, p.y);
+                double const wz = d == 2 ? dbernstein(n, b, p.z) : bernstein(n, b, p.z);
+                auto const& cp = v[a + (n + 1) * b + (n + 1) * (n + 1) * k];
+                double const w = wx * wy * wz;
+                r[0] += w * cp.x; r[1] += w * cp.y; r[2] += w * cp.z;
+            }
+    return r;
+}
+
+template<uint n>
+dvec3 refnormal(beziervolume<n> const& v, vector3 const& p, vector3 const& normal)
+{
+    auto const dx = refvolume(v, p, 0), dy = refvolume(v, p, 1), dz = refvolume(v, p, 2);
+    dvec3 r;
+    for (uint i = 0; i < 3; ++i) r[i] = normal.x * dx[i] + normal.y * dy[i] + normal.z * dz[i];
+    double const len = std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+    for (auto& c : r) c /= len;
+    return r;
+}
+
+template<uint n>
+dvec3 reftriangle(beziertriangle<n> const& patch, vector3 const& uvw)
+{
+    dvec3 r = {};
+    for (uint j = 0; j <= n; ++j)
+        for (uint k = 0; k <= n - j; ++k)
+        {
+            uint const i = n - j - k;
+            double const w = binomial(n, i) * binomial(n - i, j) * std::pow(double(uvw.x), double(i)) * std::pow(double(uvw.y), double(j)) * std::pow(double(uvw.z), double(k));
+            auto const& cp = patch[stdx::triindex<n>::to1d(j, k)];
+            r[0] += w * cp.x; r[1] += w * cp.y; r[2] += w * cp.z;
+        }
+    return r;
+}
+
+template<uint n>
+dvec3 refsurface(beziersurface<n> const& patch, vector2 const& uv)
+{
+    dvec3 r = {};
+    for (uint b = 0; b <= n; ++b)
+        for (uint a = 0; a <= n; ++a)
+        {
+            double const w = bernstein(n, a, uv.x) * bernstein(n, b, uv.y);
+            auto const& cp = patch[a + (n + 1) * b];
+            r[0] += w * cp.x; r[1] += w * cp.y; r[2] += w * cp.z;
+        }
+    return r;
+}
+
+double error(vector3 const& v, dvec3 const& ref) { return std::max({ std::fabs(v.x - ref[0]), std::fabs(v.y - ref[1]), std::fabs(v.z - ref[2]) }); }
+
+struct benchdata
+{
+    beziervolume<2> vol2;
+    beziervolume<3> vol3;
+    beziervolume<4> vol4;
+    beziertriangle<2> tri2;
+    beziersurface<2> surf2;
+    std::vector<geometry::vertex> vertices;
+    std::vector<vector3> barycentrics;
+    std::vector<vector2> uvs;
+};
+
+template<uint n>
+beziervolume<n> randomvolume(std::mt19937& re)
+{
+    std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+    beziervolume<n> v;
+    for (uint i = 0; i < v.numcontrolpts; ++i)
+    {
+        auto const idx = stdx::grididx<2>::from1d(n, i);
+        v.controlnet[i] = vector3{ float(idx[0]), float(idx[2]), float(idx[1]) } / float(n) + vector3{ jitter(re), jitter(re), jitter(re) };
+    }
+    return v;
+}
+
+benchdata makedata(uint count)
+{
+    auto& re = engineutils::getrandomengine();
+    re.seed(7);
+
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::uniform_real_distribution<float> signedunit(-1.f, 1.f);
+
+    benchdata data;
+    data.vol2 = randomvolume<2>(re);
+    data.vol3 = randomvolume<3>(re);
+    data.vol4 = randomvolume<4>(re);
+    for (auto& cp : data.tri2.controlnet) cp = { signedunit(re), signedunit(re), signedunit(re) };
+    for (auto& cp : data.surf2.controlnet) cp = { signedunit(re), signedunit(re), signedunit(re) };
+
+    data.vertices.reserve(count);
+    data.barycentrics.reserve(count);
+    data.uvs.reserve(count);
+    for (uint i = 0; i < count; ++i)
+    {
+        data.vertices.emplace_back(vector3{ unit(re), unit(re), unit(re) }, vector3{ signedunit(re), signedunit(re), signedunit(re) }.Normalized());
+
+        float const u = unit(re), v = unit(re) * (1.f - u);
+        data.barycentrics.emplace_back(u, v, 1.f - u - v);
+        data.uvs.emplace_back(unit(re), unit(re));
+    }
+
+    return data;
+}
+
+// deform a body by squeezing it against a small room, so the trivariate reference runs on a non trivial lattice
+geometry::ffd_object makedeformedbody()
+{
+    std::vector<geometry::vertex> box;
+    for (uint i = 0; i < 8; ++i)
+        box.emplace_back(vector3{ float(i & 1), float((i >> 1) & 1) * 2.f, float((i >> 2) & 1) * 3.f }, vector3::UnitY);
+
+    // the body is used after this returns, so its world has to outlive the call
+    static geometry::ffd_world world;
+    auto body = world.add({ vector3::Zero, std::make_shared<geometry::ffdmesh const>(box) });
+    body.svelocity({ 3.f, 2.f, 1.f });
+
+    vector3 const roomextents = { 0.4f, 0.9f, 1.4f };
+    geometry::aabb const room{ body.center() - roomextents, body.center() + roomextents };
+    geometry::distancefield walls{ { room.min_pt - vector3{ 0.5f }, room.max_pt + vector3{ 0.5f } }, 0.1f };
+    walls.addroom(room);
+    for (uint i = 0; i < 20; ++i)
+    {
+        body.resolve_collision(walls, 1.f / 60.f);
+        body.update(1.f / 60.f);
+    }
+
+    return body;
+}
+
+// the inputs of one timed size, in the layouts the bulk kernels take
+struct batch
+{
+    std::vector<geometry::vertex> vertices;
+    beziermaths::vertexsoa soa;
+    beziermaths::weightcache separable;
+    beziermaths::weightcache tensor;
+
+    // outputs of the kernels that write into caller storage, sized once outside the timed region
+    mutable std::vector<geometry::vertex> out;
+    mutable std::vector<vector3> physx;
+};
+
+struct kernel
+{
+    std::string name;
+    double flops;
+    std::function<void(benchdata const&, batch const&, uint)> run;
+    std::function<double(benchdata const&, uint)> maxerror;
+
+    // sizes above this are not timed
+    uint maxcount = std::numeric_limits<uint>::max();
+};
+
+// the generic degree n kernel, vol picks the volume of that degree from the bench data
+template<uint n>
+kernel genericbulkkernel(beziervolume<n> benchdata::* vol)
+{
+    return { "bulkevaluate<" + std::to_string(n) + ">(soa)", bulkevalflopsn(n),
+        [=](benchdata const& d, batch const& b, uint count) { bench::donotoptimize(bulkevaluate<n>(d.*vol, b.soa)); },
+        [=](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            auto const res = bulkevaluate<n>(d.*vol, vertexsoa({ d.vertices.begin(), d.vertices.begin() + count }));
+            for (uint i = 0; i < count; ++i)
+                err = std::max({ err, error(res[i].position, refvolume(d.*vol, d.vertices[i].position)), error(res[i].normal, refnormal(d.*vol, d.vertices[i].position, d.vertices[i].normal)) });
+            return err;
+        } };
+}
+
+// the tensor cache is 432 bytes per vertex, keep it under a gigabyte
+constexpr uint maxtensorverts = 2000000;
+}
+
+int main(int argc, char** argv)
+{
+    using stdx::uint;
+
+    uint const maxverts = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+    uint const reps = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 3;
+
+    auto const data = makedata(maxverts);
+    auto const body = makedeformedbody();
+
+    std::vector<kernel> kernels;
+    kernels.push_back({ "bulkevaluate", bulkevalflops,
+        [&](benchdata const& d, batch const& b, uint count) { bench::donotoptimize(bulkevaluate(d.vol2, b.vertices)); },
+        [&](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            auto const res = bulkevaluate(d.vol2, { d.vertices.begin(), d.vertices.begin() + count });
+            for (uint i = 0; i < count; ++i)
+                err = std::max({ err, error(res[i].position, refvolume(d.vol2, d.vertices[i].position)), error(res[i].normal, refnormal(d.vol2, d.vertices[i].position, d.vertices[i].normal)) });
+            return err;
+        } });
+
+    kernels.push_back({ "bulkevaluate(soa)", bulkevalflops,
+        [&](benchdata const& d, batch const& b, uint count) { bench::donotoptimize(bulkevaluate(d.vol2, b.soa)); },
+        [&](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            auto const res = bulkevaluate(d.vol2, vertexsoa({ d.vertices.begin(), d.vertices.begin() + count }));
+            for (uint i = 0; i < count; ++i)
+                err = std::max({ err, error(res[i].position, refvolume(d.vol2, d.vertices[i].position)), error(res[i].normal, refnormal(d.vol2, d.vertices[i].position, d.vertices[i].normal)) });
+            return err;
+        } });
+
+    // same kernel as above minus the allocation, and with the translated positions written in the same pass
+    kernels.push_back({ "bulkevaluate(soa, spans)", bulkevalflops + 3.0,
+        [&](benchdata const& d, batch const& b, uint count) { bulkevaluate(d.vol2, b.soa, b.out, b.physx, vector3::One); bench::donotoptimize(b.out.data()); },
+        [&](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            vertexsoa const soa({ d.vertices.begin(), d.vertices.begin() + count });
+            std::vector<geometry::vertex> out(count);
+            std::vector<vector3> physx(count);
+            bulkevaluate(d.vol2, soa, out, physx, vector3::One);
+            for (uint i = 0; i < count; ++i)
+            {
+                auto const ref = refvolume(d.vol2, d.vertices[i].position);
+                err = std::max({ err, error(out[i].position, ref), error(physx[i], { ref[0] + 1.0, ref[1] + 1.0, ref[2] + 1.0 }), error(out[i].normal, refnormal(d.vol2, d.vertices[i].position, d.vertices[i].normal)) });
+            }
+            return err;
+        } });
+
+    // every table the cpu supports, called directly so the instruction sets can be compared in one run
+    for (auto const& table : { &beziermaths::kernels::scalar(), &beziermaths::kernels::sse4(), &beziermaths::kernels::avx2(), &beziermaths::kernels::avx512() })
+    {
+        if (table->isa > simd::detect())
+            continue;
+
+        auto const evaluate = [table](beziervolume<2> const& v, vertexsoa const& soa)
+        {
+            std::vector<geometry::vertex> res(soa.size());
+            beziermaths::kernels::input const in{ soa.x.data(), soa.y.data(), soa.z.data(), soa.nx.data(), soa.ny.data(), soa.nz.data(), soa.size() };
+            table->bulkevaluate(&v[0].x, in, { &res[0].position.x, &res[0].normal.x, sizeof(geometry::vertex) / sizeof(float) });
+            return res;
+        };
+
+        kernels.push_back({ std::string("bulkevaluate(soa, ") + simd::name(table->isa) + ")", bulkevalflops,
+            [=](benchdata const& d, batch const& b, uint count) { bench::donotoptimize(evaluate(d.vol2, b.soa)); },
+            [=](benchdata const& d, uint count)
+            {
+                double err = 0.0;
+                auto const res = evaluate(d.vol2, vertexsoa({ d.vertices.begin(), d.vertices.begin() + count }));
+                for (uint i = 0; i < count; ++i)
+                    err = std::max({ err, error(res[i].position, refvolume(d.vol2, d.vertices[i].position)), error(res[i].normal, refnormal(d.vol2, d.vertices[i].position, d.vertices[i].normal)) });
+                return err;
+            } });
+    }
+
+    // the cached variants do the same contractions, minus the basis evaluation
+    for (auto const storage : { weightstorage::separable, weightstorage::tensor })
+    {
+        auto const cached = [storage](batch const& b) -> weightcache const& { return storage == weightstorage::separable ? b.separable : b.tensor; };
+        kernels.push_back({ storage == weightstorage::separable ? "bulkevaluate(separable)" : "bulkevaluate(tensor)", bulkevalflops - 6.0 * basisflops,
+            [=](benchdata const& d, batch const& b, uint count) { bench::donotoptimize(bulkevaluate(d.vol2, b.soa, cached(b))); },
+            [=](benchdata const& d, uint count)
+            {
+                double err = 0.0;
+                vertexsoa const soa({ d.vertices.begin(), d.vertices.begin() + count });
+                auto const res = bulkevaluate(d.vol2, soa, weightcache(soa, storage));
+                for (uint i = 0; i < count; ++i)
+                    err = std::max({ err, error(res[i].position, refvolume(d.vol2, d.vertices[i].position)), error(res[i].normal, refnormal(d.vol2, d.vertices[i].position, d.vertices[i].normal)) });
+                return err;
+            }, storage == weightstorage::tensor ? maxtensorverts : std::numeric_limits<uint>::max() });
+    }
+
+    kernels.push_back({ "evaluatefast<2>", evalfastflops,
+        [&](benchdata const& d, batch const&, uint count)
+        {
+            vector3 sum = vector3::Zero;
+            for (uint i = 0; i < count; ++i)
+            {
+                auto const [pos, partials] = evaluatefast(d.vol2, d.vertices[i].position);
+                sum += pos + partials.Right() + partials.Up() + partials.Backward();
+            }
+            bench::donotoptimize(sum);
+        },
+        [&](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            for (uint i = 0; i < count; ++i)
+                err = std::max(err, error(evaluatefast(d.vol2, d.vertices[i].position).first, refvolume(d.vol2, d.vertices[i].position)));
+            return err;
+        } });
+
+    // higher degrees at the cost of the quadratic path, which bulkevaluate<2> measures the generic kernel against
+    kernels.push_back(genericbulkkernel(&benchdata::vol2));
+    kernels.push_back(genericbulkkernel(&benchdata::vol3));
+    kernels.push_back(genericbulkkernel(&benchdata::vol4));
+
+    kernels.push_back({ "evaluatefast<3>", volumeflops(3) + 3.0 * double(4 * 3 + 2),
+        [&](benchdata const& d, batch const&, uint count)
+        {
+            vector3 sum = vector3::Zero;
+            for (uint i = 0; i < count; ++i) sum += evaluatefast(d.vol3, d.vertices[i].position);
+            bench::donotoptimize(sum);
+        },
+        [&](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            for (uint i = 0; i < count; ++i) err = std::max(err, error(evaluatefast(d.vol3, d.vertices[i].position), refvolume(d.vol3, d.vertices[i].position)));
+            return err;
+        } });
+
+    kernels.push_back({ "decasteljau<2>::volume", decasteljauvolumeflops(2),
+        [&](benchdata const& d, batch const&, uint count)
+        {
+            vector3 sum = vector3::Zero;
+            for (uint i = 0; i < count; ++i) sum += decasteljau<2, 0>::volume(d.vol2, d.vertices[i].position).controlnet[0];
+            bench::donotoptimize(sum);
+        },
+        [&](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            for (uint i = 0; i < count; ++i) err = std::max(err, error(decasteljau<2, 0>::volume(d.vol2, d.vertices[i].position).controlnet[0], refvolume(d.vol2, d.vertices[i].position)));
+            return err;
+        } });
+
+    kernels.push_back({ "decasteljau<3>::volume", decasteljauvolumeflops(3),
+        [&](benchdata const& d, batch const&, uint count)
+        {
+            vector3 sum = vector3::Zero;
+            for (uint i = 0; i < count; ++i) sum += decasteljau<3, 0>::volume(d.vol3, d.vertices[i].position).controlnet[0];
+            bench::donotoptimize(sum);
+        },
+        [&](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            for (uint i = 0; i < count; ++i) err = std::max(err, error(decasteljau<3, 0>::volume(d.vol3, d.vertices[i].position).controlnet[0], refvolume(d.vol3, d.vertices[i].position)));
+            return err;
+        } });
+
+    kernels.push_back({ "decasteljau<2>::triangle", decasteljautriangleflops(2),
+        [&](benchdata const& d, batch const&, uint count)
+        {
+            vector3 sum = vector3::Zero;
+            for (uint i = 0; i < count; ++i) sum += decasteljau<2, 0>::triangle(d.tri2, d.barycentrics[i]).controlnet[0];
+            bench::donotoptimize(sum);
+        },
+        [&](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            for (uint i = 0; i < count; ++i) err = std::max(err, error(decasteljau<2, 0>::triangle(d.tri2, d.barycentrics[i]).controlnet[0], reftriangle(d.tri2, d.barycentrics[i])));
+            return err;
+        } });
+
+    kernels.push_back({ "decasteljau<2>::surface", decasteljausurfaceflops(2),
+        [&](benchdata const& d, batch const&, uint count)
+        {
+            vector3 sum = vector3::Zero;
+            for (uint i = 0; i < count; ++i) sum += decasteljau<2, 0>::surface(d.surf2, d.uvs[i]).controlnet[0];
+            bench::donotoptimize(sum);
+        },
+        [&](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            for (uint i = 0; i < count; ++i) err = std::max(err, error(decasteljau<2, 0>::surface(d.surf2, d.uvs[i]).controlnet[0], refsurface(d.surf2, d.uvs[i])));
+            return err;
+        } });
+
+    kernels.push_back({ "eval_bez_trivariate", trivariateflops,
+        [&](benchdata const& d, batch const&, uint count)
+        {
+            vector3 sum = vector3::Zero;
+            for (uint i = 0; i < count; ++i)
+            {
+                auto const& p = d.vertices[i].position;
+                sum += body.eval_bez_trivariate(p.x, p.y, p.z);
+            }
+            bench::donotoptimize(sum);
+        },
+        [&](benchdata const& d, uint count)
+        {
+            double err = 0.0;
+            for (uint i = 0; i < count; ++i)
+            {
+                auto const& p = d.vertices[i].position;
+                err = std::max(err, error(body.eval_bez_trivariate(p.x, p.y, p.z), refvolume(body.volume(), p)));
+            }
+            return err;
+        } });
+
+    std::printf("isa %s(detected %s), override with SOFTBODY_ISA\n\n", simd::name(simd::active()), simd::name(simd::detect()));
+    std::printf("accuracy against double precision reference(%zu samples)\n", std::min(accuracysamples, maxverts));
+    std::printf("%-26s %14s\n", "kernel", "max abs error");
+    for (auto const& k : kernels)
+        std::printf("%-26s %14.3e\n", k.name.c_str(), k.maxerror(data, std::min(accuracysamples, maxverts)));
+
+    // the bulk kernels take containers so each size gets its own copy of the inputs, made outside the timed region
+    std::vector<std::vector<double>> seconds(kernels.size());
+    for (uint count = 1000; count <= maxverts; count *= 10)
+    {
+        batch b{ { data.vertices.begin(), data.vertices.begin() + count } };
+        b.soa = vertexsoa(b.vertices);
+        b.out.resize(count), b.physx.resize(count);
+        b.separable = weightcache(b.soa, weightstorage::separable);
+        if (count <= maxtensorverts) b.tensor = weightcache(b.soa, weightstorage::tensor);
+        for (uint k = 0; k < kernels.size(); ++k)
+            seconds[k].push_back(count <= kernels[k].maxcount ? bench::timeit([&] { kernels[k].run(data, b, count); }, reps) : 0.0);
+    }
+
+    std::printf("\n%-26s %10s %12s %10s\n", "kernel", "verts", "ns/vertex", "gflops");
+    for (uint k = 0; k < kernels.size(); ++k)
+    {
+        uint count = 1000;
+        for (auto const t : seconds[k])
+        {
+            if (count <= kernels[k].maxcount)
+                std::printf("%-26s %10zu %12.2f %10.2f\n", kernels[k].name.c_str(), count, t * 1e9 / count, kernels[k].flops * count / t * 1e-9);
+            count *= 10;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include "benchutils.h"
+#include "stdx/stdx.h"
+#include "stdx/vec.h"
+#include "gameimplementations/fluidsimulation/fluidcore.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <utility>
+#include <numbers>
+
+// times the fluidcore stencil kernels on grids from 64^2 up to maxl^2 and measures the divergence left by the pressure projection
+// usage : softbody_bench_fluid [maxl] [reps] [maxiters]
+
+using namespace fluid;
+
+namespace
+{
+using stdx::uint;
+
+constexpr float dt = 1.f / 60.f;
+constexpr float diff = 0.5f;
+constexpr uint projectioniters = 4;
+
+// nominal bytes streamed per processed cell, neighbours are assumed to come from cache
+// s is the size of a field element, fields returned by value are zero initialized before they are written
+constexpr double jacobibytes(double s, uint niters) { return 2.0 * s + double(niters) * 3.0 * s; }
+constexpr double advectbytes(double s) { return sizeof(stdx::vec2) + 3.0 * s; }
+constexpr double divergencebytes() { return sizeof(stdx::vec2) + 2.0 * sizeof(stdx::vec1); }
+constexpr double gradientbytes() { return sizeof(stdx::vec1) + 2.0 * sizeof(stdx::vec2); }
+constexpr double boundbytes(double s) { return 2.0 * s + 2.0 * sizeof(stdx::grididx<1>); }
+
+struct timing
+{
+    std::string name;
+    uint l;
+    double cells;
+    double seconds;
+    double bytespercell;
+};
+
+struct residual
+{
+    uint l;
+    uint niters;
+    double before;
+    double after;
+};
+
+// a divergence free swirl that is tangential at the walls, plus a smooth radial splat like the one the demo adds under the cursor
+// the splat is the only divergent part, so the residual measures the pressure solve rather than the boundary handling
+template<uint l>
+vecfield22<l> initialvelocity()
+{
+    using idx = stdx::grididx<1>;
+
+    vecfield22<l> v;
+    float const c = float(l) * 0.5f;
+    float const radius = float(l) / 8.f;
+    float const w = std::numbers::pi_v<float> / float(l - 1);
+    for (uint j(1); j < l - 1; ++j)
+        for (uint i(1); i < l - 1; ++i)
+        {
+            float const x = float(i), y = float(j);
+            float const dx = (x - c) / radius, dy = (y - c) / radius;
+            stdx::vec2 const swirl{ std::sin(w * x) * std::cos(w * y), -std::cos(w * x) * std::sin(w * y) };
+            v[idx::to1d<l - 1>({ i, j })] = swirl + stdx::vec2{ dx, dy } * (2.5f * std::exp(-(dx * dx + dy * dy)));
+        }
+
+    return v;
+}
+
+template<uint l>
+vecfield21<l> initialpressure()
+{
+    std::mt19937 re(13);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+    vecfield21<l> p;
+    for (auto& c : p) c = stdx::vec1{ dist(re) };
+    return p;
+}
+
+// root mean square of the divergence over interior cells
+template<uint l>
+double rmsdivergence(vecfield22<l> const& v)
+{
+    using idx = stdx::grididx<1>;
+    auto const div = divergence<l>(v);
+
+    double sum = 0.0;
+    for (uint j(1); j < l - 1; ++j)
+        for (uint i(1); i < l - 1; ++i)
+        {
+            double const d = div[idx::to1d<l - 1>({ i, j })];
+            sum += d * d;
+        }
+
+    return std::sqrt(sum / double((l - 2) * (l - 2)));
+}
+
+template<uint l>
+void benchgrid(uint reps, uint maxiters, std::vector<timing>& timings, std::vector<residual>& residuals)
+{
+    double const interior = double((l - 2) * (l - 2));
+    double const boundary = double(4 * (l - 2));
+    constexpr double s1 = sizeof(stdx::vec1), s2 = sizeof(stdx::vec2);
+
+    auto v = initialvelocity<l>();
+    auto const p = initialpressure<l>();
+    auto const div = divergence<l>(v);
+
+    // jacobi cells are cell updates, so the pressure solve of the demo counts each cell projectioniters times
+    timings.push_back({ "jacobi2d", l, interior * projectioniters, bench::timeit([&] { bench::donotoptimize(jacobi2d(p, div, projectioniters, 1.f, 4.f)); }, reps), jacobibytes(s1, projectioniters) / projectioniters });
+    timings.push_back({ "advect2d", l, interior, bench::timeit([&] { bench::donotoptimize(advect2d(v, v, dt)); }, reps), advectbytes(s2) });
+    timings.push_back({ "divergence", l, interior, bench::timeit([&] { bench::donotoptimize(divergence<l>(v)); }, reps), divergencebytes() });
+    timings.push_back({ "gradient", l, interior, bench::timeit([&] { bench::donotoptimize(gradient(p)); }, reps), gradientbytes() });
+    timings.push_back({ "diffuse", l, interior * 4, bench::timeit([&] { bench::donotoptimize(diffuse({}, v, dt, diff)); }, reps), jacobibytes(s2, 4) / 4 });
+
+    // bound works in place and is idempotent for a given field, so repeating it on the same field is fine
+    timings.push_back({ "bound", l, boundary, bench::timeit([&] { bound(v, -1.f); bench::donotoptimize(v); }, reps), boundbytes(s2) });
+
+    // the velocity step of fluidsimulation::update, with increasing jacobi iterations for the pressure solve
+    v = initialvelocity<l>();
+    v = advect2d(v, v, dt);
+    v = diffuse({}, v, dt, diff);
+    double const before = rmsdivergence<l>(v);
+    for (uint niters = projectioniters; niters <= maxiters; niters *= 4)
+    {
+        auto projected = v;
+        project(projected, niters);
+        bound(projected, -1.f);
+        residuals.push_back({ l, niters, before, rmsdivergence<l>(projected) });
+    }
+}
+
+template<uint ... ls>
+void benchgrids(std::integer_sequence<uint, ls...>, uint maxl, uint reps, uint maxiters, std::vector<timing>& timings, std::vector<residual>& residuals)
+{
+    ((ls <= maxl ? benchgrid<ls>(reps, maxiters, timings, residuals) : void()), ...);
+}
+}
+
+int main(int argc, char** argv)
+{
+    using stdx::uint;
+
+    uint const maxl = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    uint const reps = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 3;
+    uint const maxiters = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 256;
+
+    // grid sizes are template arguments of the kernels, so they are fixed at compile time
+    std::vector<timing> timings;
+    std::vector<residual> residuals;
+    benchgrids(std::integer_sequence<uint, 64, 128, 256, 512, 1024, 2048, 4096>{}, maxl, reps, maxiters, timings, residuals);
+
+    // bytes/cell is the nominal streamed traffic, gb/s is that times the measured rate
+    std::printf("\n%-12s %10s %14s %12s %12s %10s\n", "kernel", "grid", "cells", "mcells/s", "bytes/cell", "gb/s");
+    for (auto const& t : timings)
+    {
+        double const rate = t.cells / t.seconds;
+        std::printf("%-12s %10s %14.0f %12.1f %12.1f %10.2f\n", t.name.c_str(), (std::to_string(t.l) + "^2").c_str(), t.cells, rate * 1e-6, t.bytespercell, rate * t.bytespercell * 1e-9);
+    }
+
+    std::printf("\nrms divergence after the velocity step(advect, diffuse, project, bound), the demo uses %zu iterations\n", projectioniters);
+    std::printf("%10s %8s %14s %14s %10s\n", "grid", "iters", "before", "after", "after/before");
+    for (auto const& r : residuals)
+        std::printf("%10s %8zu %14.4e %14.4e %10.4f\n", (std::to_string(r.l) + "^2").c_str(), r.niters, r.before, r.after, r.after / r.before);
+
+    return 0;
+}
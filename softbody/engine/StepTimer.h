@@ -24,7 +24,8 @@ public:
         m_framesThisSecond(0),
         m_qpcSecondCounter(0),
         m_isFixedTimeStep(false),
-        m_targetElapsedTicks(TicksPerSecond / 60)
+        m_targetElapsedTicks(TicksPerSecond / 60),
+        m_maxUpdatesPerTick(0)
     {
         QueryPerformanceFrequency(&m_qpcFrequency);
         QueryPerformanceCounter(&m_qpcLastTime);
@@ -54,6 +55,12 @@ public:
     void SetTargetElapsedTicks(UINT64 targetElapsed)    { m_targetElapsedTicks = targetElapsed; }
     void SetTargetElapsedSeconds(double targetElapsed)    { m_targetElapsedTicks = SecondsToTicks(targetElapsed); }
 
+    // Set how many updates a tick may run in fixed timestep mode before the rest of the backlog is dropped, 0 for no limit.
+    void SetMaxUpdatesPerTick(UINT32 maxUpdates)        { m_maxUpdatesPerTick = maxUpdates; }
+
+    // Get how far the current time is between the last two fixed updates, in [0, 1). Always 1 in variable timestep mode.
+    double GetInterpolation() const                        { return m_isFixedTimeStep ? static_cast<double>(m_leftOverTicks) / m_targetElapsedTicks : 1.0; }
+
     // Integer format represents time using 10,000,000 ticks per second.
     static const UINT64 TicksPerSecond = 10000000;
 
@@ -74,10 +81,12 @@ public:
         m_qpcSecondCounter = 0;
     }
 
-    typedef void(*LPUPDATEFUNC) (void);
+    // Update timer state without an Update function.
+    void Tick() { Tick([]() {}); }
 
     // Update timer state, calling the specified Update function the appropriate number of times.
-    void Tick(LPUPDATEFUNC update = nullptr)
+    template<typename TUpdate>
+    void Tick(TUpdate const& update)
     {
         // Query the current time.
         LARGE_INTEGER currentTime;
@@ -119,17 +128,24 @@ public:
 
             m_leftOverTicks += timeDelta;
 
+            UINT32 updates = 0;
             while (m_leftOverTicks >= m_targetElapsedTicks)
             {
+                // When updates take longer than the time they simulate, catching up would only make the next tick longer.
+                // Drop the whole steps that are left and keep the fraction, so the simulation slows down instead.
+                if (m_maxUpdatesPerTick != 0 && updates == m_maxUpdatesPerTick)
+                {
+                    m_leftOverTicks %= m_targetElapsedTicks;
+                    break;
+                }
+
                 m_elapsedTicks = m_targetElapsedTicks;
                 m_totalTicks += m_targetElapsedTicks;
                 m_leftOverTicks -= m_targetElapsedTicks;
                 m_frameCount++;
+                updates++;
 
-                if (update)
-                {
-                    update();
-                }
+                update();
             }
         }
         else
@@ -140,10 +156,7 @@ public:
             m_leftOverTicks = 0;
             m_frameCount++;
 
-            if (update)
-            {
-                update();
-            }
+            update();
         }
 
         // Track the current framerate.
@@ -180,4 +193,5 @@ private:
     // Members for configuring fixed timestep mode.
     bool m_isFixedTimeStep;
     UINT64 m_targetElapsedTicks;
+    UINT32 m_maxUpdatesPerTick;
 };
@@ -24,6 +24,11 @@ softbody::softbody(gamedata const& data)
     , m_fenceEvent{}
     , m_fenceValues{}
 {
+    // the simulation runs at a fixed rate whatever the frame rate, frames are drawn between its last two steps
+    m_timer.SetFixedTimeStep(true);
+    m_timer.SetTargetElapsedSeconds(data.fixedstep);
+    m_timer.SetMaxUpdatesPerTick(data.maxsubsteps);
+
     game = game_creator::create_instance<currentgame>(data);
 }
 
@@ -252,7 +257,7 @@ void softbody::load_assetsandgeometry()
 
 void softbody::OnUpdate()
 {
-    m_timer.Tick(NULL);
+    m_timer.Tick([this]() { game->update(static_cast<float>(m_timer.GetElapsedSeconds())); });
 
     if (m_frameCounter++ % 30 == 0)
     {
@@ -264,7 +269,7 @@ void softbody::OnUpdate()
         SetCustomWindowText(title);
     }
 
-    game->update(static_cast<float>(m_timer.GetElapsedSeconds()));
+    game->interpolate(static_cast<float>(m_timer.GetInterpolation()));
 }
 
 // Render the scene.
@@ -11,6 +11,10 @@ struct gamedata
 	float nearplane = 0.1f;
 	float farplane = 1000.f;
 
+	// games are updated in steps of fixedstep seconds, at most maxsubsteps of them per frame
+	float fixedstep = 1.f / 60.f;
+	unsigned maxsubsteps = 4;
+
 	float get_aspect_ratio() const { return static_cast<float>(width) / static_cast<float>(height); }
 };
 
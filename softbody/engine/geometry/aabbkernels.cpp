@@ -0,0 +1,54 @@
+#include "aabbkernels.h"
+
+#include <algorithm>
+
+// portable fallback, softbody_bench_beziermaths compares the avx2 kernels to it
+namespace
+{
+using stdx::uint;
+
+using namespace geometry::aabbkernels;
+
+uint overlaps(float const* box, boxrange const& range, uint* out)
+{
+    uint num = 0;
+    for (uint i = range.first; i < range.first + range.count; ++i)
+    {
+        // x first, it rejects most boxes
+        if (box[0] <= range.max[0][i] && range.min[0][i] <= box[3] && box[1] <= range.max[1][i] && range.min[1][i] <= box[4] && box[2] <= range.max[2][i] && range.min[2][i] <= box[5])
+            out[num++] = i;
+    }
+
+    return num;
+}
+
+void fromtriangles(float const* positions, uint const* indices, uint const* tris, uint count, boxoutput const& out)
+{
+    for (uint i = 0; i < count; ++i)
+    {
+        float const* v0 = positions + indices[tris[i]] * 3;
+        float const* v1 = positions + indices[tris[i] + 1] * 3;
+        float const* v2 = positions + indices[tris[i] + 2] * 3;
+        for (uint c = 0; c < 3; ++c)
+        {
+            out.min[c][i] = std::min(v0[c], std::min(v1[c], v2[c]));
+            out.max[c][i] = std::max(v0[c], std::max(v1[c], v2[c]));
+        }
+    }
+}
+}
+
+namespace geometry::aabbkernels
+{
+table const& scalar()
+{
+    static table const t{ simd::isa::scalar, overlaps, fromtriangles };
+    return t;
+}
+
+table const& active()
+{
+    static table const& t = simd::active() >= simd::isa::avx2 ? avx2() : scalar();
+    return t;
+}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "stdx/stdxcore.h"
+#include "engine/simd.h"
+
+// raw kernels behind geometry::aabbsoa, one table per instruction set
+namespace geometry::aabbkernels
+{
+using stdx::uint;
+
+// boxes per register of the widest table
+inline constexpr uint width = 8;
+
+// boxes [first, first + count) of a structure of arrays, the kernels read nothing past the last box
+struct boxrange
+{
+    float const* min[3];
+    float const* max[3];
+    uint first;
+    uint count;
+};
+
+struct boxoutput
+{
+    float* min[3];
+    float* max[3];
+};
+
+// box is min xyz followed by max xyz, out gets the indices of the boxes in range that overlap it(touching ones too) in increasing order
+// returns how many were written, out needs room for range.count rounded up to width
+using overlaps_fn = uint(*)(float const* box, boxrange const& range, uint* out);
+
+// box i of out bounds the triangle whose first index is at tris[i], positions are 3 floats apart
+using fromtriangles_fn = void(*)(float const* positions, uint const* indices, uint const* tris, uint count, boxoutput const& out);
+
+struct table
+{
+    simd::isa isa;
+    overlaps_fn overlaps;
+    fromtriangles_fn fromtriangles;
+};
+
+table const& scalar();
+table const& avx2();
+
+// table for simd::active()
+table const& active();
+}
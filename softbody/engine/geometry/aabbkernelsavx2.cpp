@@ -0,0 +1,103 @@
+#include "aabbkernels.h"
+
+#include <array>
+#include <cstdint>
+#include <immintrin.h>
+
+// 8 boxes per register, this file is built with /arch:AVX2
+namespace
+{
+using stdx::uint;
+
+using namespace geometry::aabbkernels;
+
+// positions of the set bits of each 8 bit mask, 4 bits each from the lowest, the permutation that packs the overlapping lanes to the front
+constexpr std::array<uint32_t, 256> packtable = []()
+{
+    std::array<uint32_t, 256> t{};
+    for (uint32_t m = 0; m < 256; ++m)
+        for (uint32_t b = 0, k = 0; b < 8; ++b)
+            if (m & (1u << b)) t[m] |= b << (4 * k++);
+
+    return t;
+}();
+
+// lanes below n set, for the last partial register of a range
+__m256i lanemask(uint n) { return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(n)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+
+__m256 load(float const* src, uint n) { return n == width ? _mm256_loadu_ps(src) : _mm256_maskload_ps(src, lanemask(n)); }
+
+void store(float* dst, __m256 v, uint n)
+{
+    if (n == width) _mm256_storeu_ps(dst, v);
+    else _mm256_maskstore_ps(dst, lanemask(n), v);
+}
+
+uint overlaps(float const* box, boxrange const& range, uint* out)
+{
+    __m256 const bmin[3] = { _mm256_set1_ps(box[0]), _mm256_set1_ps(box[1]), _mm256_set1_ps(box[2]) };
+    __m256 const bmax[3] = { _mm256_set1_ps(box[3]), _mm256_set1_ps(box[4]), _mm256_set1_ps(box[5]) };
+    __m256i const shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+
+    uint num = 0;
+    uint const end = range.first + range.count;
+    for (uint i = range.first; i < end; i += width)
+    {
+        uint const n = end - i < width ? end - i : width;
+
+        __m256 overlap = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (uint c = 0; c < 3; ++c)
+        {
+            overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(bmin[c], load(range.max[c] + i, n), _CMP_LE_OQ));
+            overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(load(range.min[c] + i, n), bmax[c], _CMP_LE_OQ));
+        }
+
+        uint const mask = static_cast<uint>(_mm256_movemask_ps(overlap)) & ((1u << n) - 1);
+        if (mask == 0)
+            continue;
+
+        // pack the indices of the overlapping lanes and write all 8, only the first popcount of them count
+        __m256i const perm = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(packtable[mask])), shifts), _mm256_set1_epi32(7));
+        __m256i const packed = _mm256_permutevar8x32_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), perm);
+        __m256i const base = _mm256_set1_epi64x(static_cast<long long>(i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + num), _mm256_add_epi64(base, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(packed))));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + num + 4), _mm256_add_epi64(base, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(packed, 1))));
+        num += _mm_popcnt_u32(static_cast<unsigned>(mask));
+    }
+
+    return num;
+}
+
+void fromtriangles(float const* positions, uint const* indices, uint const* tris, uint count, boxoutput const& out)
+{
+    for (uint i = 0; i < count; i += width)
+    {
+        uint const n = count - i < width ? count - i : width;
+
+        // hardware gathers are slower than scalar loads here, the vertices are transposed through the stack and reduced a register at a time
+        alignas(32) float coords[3][3][width] = {};
+        for (uint l = 0; l < n; ++l)
+            for (uint v = 0; v < 3; ++v)
+            {
+                float const* p = positions + indices[tris[i + l] + v] * 3;
+                coords[v][0][l] = p[0], coords[v][1][l] = p[1], coords[v][2][l] = p[2];
+            }
+
+        for (uint c = 0; c < 3; ++c)
+        {
+            __m256 const v0 = _mm256_load_ps(coords[0][c]), v1 = _mm256_load_ps(coords[1][c]), v2 = _mm256_load_ps(coords[2][c]);
+            store(out.min[c] + i, _mm256_min_ps(v0, _mm256_min_ps(v1, v2)), n);
+            store(out.max[c] + i, _mm256_max_ps(v0, _mm256_max_ps(v1, v2)), n);
+        }
+    }
+}
+}
+
+namespace geometry::aabbkernels
+{
+table const& avx2()
+{
+    static table const t{ simd::isa::avx2, overlaps, fromtriangles };
+    return t;
+}
+}
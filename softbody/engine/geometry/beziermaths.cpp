@@ -1,170 +1,169 @@
 #include "beziermaths.h"
-#include "immintrin.h"
+#include "beziermathskernels.h"
 
 namespace beziermaths
 {
-vector3 evaluateavx2(beziervolume<2> const& v, vector3 const& bt0, vector3 const& bt1, vector3 const& bt2)
+namespace kernels
 {
-    // literally vectorizes the following expression
-    // bt2.x * (bt1.x * (v[0] * bt0.x + v[1] * bt0.y + v[2] * bt0.z) + bt1.y * (v[3] * bt0.x + v[4] * bt0.y + v[5] * bt0.z) + bt1.z * (v[6] * bt0.x + v[7] * bt0.y + v[8] * bt0.z))
-    // + bt2.y * (bt1.x * (v[9] * bt0.x + v[10] * bt0.y + v[11] * bt0.z) + bt1.y * (v[12] * bt0.x + v[13] * bt0.y + v[14] * bt0.z) + bt1.z * (v[15] * bt0.x + v[16] * bt0.y + v[17] * bt0.z))
-    // + bt2.z * (bt1.x * (v[18] * bt0.x + v[19] * bt0.y + v[20] * bt0.z) + bt1.y * (v[21] * bt0.x + v[22] * bt0.y + v[23] * bt0.z) + bt1.z * (v[24] * bt0.x + v[25] * bt0.y + v[26] * bt0.z));
-
-    // vab is line along 3rd dim. ab represent first two dims.
-    __m256 v00 = _mm256_setr_ps(v[0].x, v[0].y, v[0].z, v[9].x, v[9].y, v[9].z, v[18].x, v[18].y);
-    __m256 v10 = _mm256_setr_ps(v[1].x, v[1].y, v[1].z, v[10].x, v[10].y, v[10].z, v[19].x, v[19].y);
-    __m256 v20 = _mm256_setr_ps(v[2].x, v[2].y, v[2].z, v[11].x, v[11].y, v[11].z, v[20].x, v[20].y);
-
-    __m256 v01 = _mm256_setr_ps(v[3].x, v[3].y, v[3].z, v[12].x, v[12].y, v[12].z, v[21].x, v[21].y);
-    __m256 v11 = _mm256_setr_ps(v[4].x, v[4].y, v[4].z, v[13].x, v[13].y, v[13].z, v[22].x, v[22].y);
-    __m256 v21 = _mm256_setr_ps(v[5].x, v[5].y, v[5].z, v[14].x, v[14].y, v[14].z, v[23].x, v[23].y);
-
-    __m256 v02 = _mm256_setr_ps(v[6].x, v[6].y, v[6].z, v[15].x, v[15].y, v[15].z, v[24].x, v[24].y);
-    __m256 v12 = _mm256_setr_ps(v[7].x, v[7].y, v[7].z, v[16].x, v[16].y, v[16].z, v[25].x, v[25].y);
-    __m256 v22 = _mm256_setr_ps(v[8].x, v[8].y, v[8].z, v[17].x, v[17].y, v[17].z, v[26].x, v[26].y);
-
-    __m256 t0x = _mm256_set1_ps(bt0.x);
-    __m256 t0y = _mm256_set1_ps(bt0.y);
-    __m256 t0z = _mm256_set1_ps(bt0.z);
-    __m256 t1x = _mm256_set1_ps(bt1.x);
-    __m256 t1y = _mm256_set1_ps(bt1.y);
-    __m256 t1z = _mm256_set1_ps(bt1.z);
-
-    __m256 t2 = _mm256_setr_ps(bt2.x, bt2.x, bt2.x, bt2.y, bt2.y, bt2.y, bt2.z, bt2.z);
-
-    // rnbx is plane with xth coordinate at n
-    __m256 r0b1 = _mm256_fmadd_ps(t0x, v00, _mm256_fmadd_ps(t0y, v10, _mm256_mul_ps(t0z, v20)));
-    __m256 r1b1 = _mm256_fmadd_ps(t0x, v01, _mm256_fmadd_ps(t0y, v11, _mm256_mul_ps(t0z, v21)));
-    __m256 r2b1 = _mm256_fmadd_ps(t0x, v02, _mm256_fmadd_ps(t0y, v12, _mm256_mul_ps(t0z, v22)));
-
-    float res[8];
-    _mm256_store_ps(res, _mm256_mul_ps(t2, _mm256_fmadd_ps(t1x, r0b1, _mm256_fmadd_ps(t1y, r1b1, _mm256_mul_ps(t1z, r2b1)))));
-
-    // compute the remaining value the scalar way
-    float const l = bt2.z * (bt1.x * (v[18].z * bt0.x + v[19].z * bt0.y + v[20].z * bt0.z) + bt1.y * (v[21].z * bt0.x + v[22].z * bt0.y + v[23].z * bt0.z) + bt1.z * (v[24].z * bt0.x + v[25].z * bt0.y + v[26].z * bt0.z));
-    return vector3{ res[0] + res[3] + res[6], res[1] + res[4] + res[7], res[2] + res[5] + l };
-}
-
-// some computations are duplicated, but performance actually is worse when caching them
-std::vector<geometry::vertex> bulkevaluate(beziervolume<2> const& v, std::vector<geometry::vertex> const& vertices)
+table const& active()
 {
-    std::vector<geometry::vertex> ret;
-                          
-    // vab is line along 3rd dim. ab represent first two dims.
-    __m256 v00 = _mm256_setr_ps(v[0].x, v[0].y, v[0].z, v[9].x, v[9].y, v[9].z, v[18].x, v[18].y);
-    __m256 v10 = _mm256_setr_ps(v[1].x, v[1].y, v[1].z, v[10].x, v[10].y, v[10].z, v[19].x, v[19].y);
-    __m256 v20 = _mm256_setr_ps(v[2].x, v[2].y, v[2].z, v[11].x, v[11].y, v[11].z, v[20].x, v[20].y);
-
-    __m256 v01 = _mm256_setr_ps(v[3].x, v[3].y, v[3].z, v[12].x, v[12].y, v[12].z, v[21].x, v[21].y);
-    __m256 v11 = _mm256_setr_ps(v[4].x, v[4].y, v[4].z, v[13].x, v[13].y, v[13].z, v[22].x, v[22].y);
-    __m256 v21 = _mm256_setr_ps(v[5].x, v[5].y, v[5].z, v[14].x, v[14].y, v[14].z, v[23].x, v[23].y);
-
-    __m256 v02 = _mm256_setr_ps(v[6].x, v[6].y, v[6].z, v[15].x, v[15].y, v[15].z, v[24].x, v[24].y);
-    __m256 v12 = _mm256_setr_ps(v[7].x, v[7].y, v[7].z, v[16].x, v[16].y, v[16].z, v[25].x, v[25].y);
-    __m256 v22 = _mm256_setr_ps(v[8].x, v[8].y, v[8].z, v[17].x, v[17].y, v[17].z, v[26].x, v[26].y);
-
-    float res[8];
-    for (auto const& vtx : vertices)
+    static table const& t = []() -> table const&
     {
-        auto const [p0, p2, p1] = vtx.position;
-        vector3 const bt0 = qbasis(p0);
-        vector3 const bt1 = qbasis(p1);
-        vector3 const bt2 = qbasis(p2);
-        vector3 const dt0 = dqbasis(p0);
-        vector3 const dt1 = dqbasis(p1);
-        vector3 const dt2 = dqbasis(p2);
-
-        vector3 pos, tn0, tn1, tn2;
-
+        switch (simd::active())
         {
-            __m256 t0x = _mm256_set1_ps(bt0.x);
-            __m256 t0y = _mm256_set1_ps(bt0.y);
-            __m256 t0z = _mm256_set1_ps(bt0.z);
-            __m256 t1x = _mm256_set1_ps(bt1.x);
-            __m256 t1y = _mm256_set1_ps(bt1.y);
-            __m256 t1z = _mm256_set1_ps(bt1.z);
-
-            __m256 t2 = _mm256_setr_ps(bt2.x, bt2.x, bt2.x, bt2.y, bt2.y, bt2.y, bt2.z, bt2.z);
-
-            // rnbx is plane with xth coordinate at n
-            __m256 r0b1 = _mm256_fmadd_ps(t0x, v00, _mm256_fmadd_ps(t0y, v10, _mm256_mul_ps(t0z, v20)));
-            __m256 r1b1 = _mm256_fmadd_ps(t0x, v01, _mm256_fmadd_ps(t0y, v11, _mm256_mul_ps(t0z, v21)));
-            __m256 r2b1 = _mm256_fmadd_ps(t0x, v02, _mm256_fmadd_ps(t0y, v12, _mm256_mul_ps(t0z, v22)));
-
-            _mm256_store_ps(res, _mm256_mul_ps(t2, _mm256_fmadd_ps(t1x, r0b1, _mm256_fmadd_ps(t1y, r1b1, _mm256_mul_ps(t1z, r2b1)))));
-
-            // compute the remaining value the scalar way
-            float const l = bt2.z * (bt1.x * (v[18].z * bt0.x + v[19].z * bt0.y + v[20].z * bt0.z) + bt1.y * (v[21].z * bt0.x + v[22].z * bt0.y + v[23].z * bt0.z) + bt1.z * (v[24].z * bt0.x + v[25].z * bt0.y + v[26].z * bt0.z));
-            pos = vector3{ res[0] + res[3] + res[6], res[1] + res[4] + res[7], res[2] + res[5] + l };
+        case simd::isa::avx512: return avx512();
+        case simd::isa::avx2: return avx2();
+        case simd::isa::sse4: return sse4();
+        default: return scalar();
         }
+    }();
 
-        // compute the normals
-        {
-            __m256 t0x = _mm256_set1_ps(dt0.x);
-            __m256 t0y = _mm256_set1_ps(dt0.y);
-            __m256 t0z = _mm256_set1_ps(dt0.z);
-            __m256 t1x = _mm256_set1_ps(bt1.x);
-            __m256 t1y = _mm256_set1_ps(bt1.y);
-            __m256 t1z = _mm256_set1_ps(bt1.z);
+    return t;
+}
 
-            __m256 t2 = _mm256_setr_ps(bt2.x, bt2.x, bt2.x, bt2.y, bt2.y, bt2.y, bt2.z, bt2.z);
+input soainput(vertexsoa const& vertices)
+{
+    return { vertices.x.data(), vertices.y.data(), vertices.z.data(), vertices.nx.data(), vertices.ny.data(), vertices.nz.data(), vertices.size() };
+}
 
-            __m256 r0b1 = _mm256_fmadd_ps(t0x, v00, _mm256_fmadd_ps(t0y, v10, _mm256_mul_ps(t0z, v20)));
-            __m256 r1b1 = _mm256_fmadd_ps(t0x, v01, _mm256_fmadd_ps(t0y, v11, _mm256_mul_ps(t0z, v21)));
-            __m256 r2b1 = _mm256_fmadd_ps(t0x, v02, _mm256_fmadd_ps(t0y, v12, _mm256_mul_ps(t0z, v22)));
+// positions and normals are written straight into the vertices, physx gets the positions moved by offset
+output vertexoutput(std::span<geometry::vertex> vertices, std::span<vector3> physx, vector3 const& offset)
+{
+    static_assert(sizeof(geometry::vertex) % sizeof(float) == 0 && sizeof(vector3) == 3 * sizeof(float));
 
-            _mm256_store_ps(res, _mm256_mul_ps(t2, _mm256_fmadd_ps(t1x, r0b1, _mm256_fmadd_ps(t1y, r1b1, _mm256_mul_ps(t1z, r2b1)))));
+    output out{ nullptr, nullptr, 0 };
+    if (!vertices.empty())
+        out.positions = &vertices.data()->position.x, out.normals = &vertices.data()->normal.x, out.stride = sizeof(geometry::vertex) / sizeof(float);
 
-            float const l = bt2.z * (bt1.x * (v[18].z * dt0.x + v[19].z * dt0.y + v[20].z * dt0.z) + bt1.y * (v[21].z * dt0.x + v[22].z * dt0.y + v[23].z * dt0.z) + bt1.z * (v[24].z * dt0.x + v[25].z * dt0.y + v[26].z * dt0.z));
-            tn0 = vector3{ res[0] + res[3] + res[6], res[1] + res[4] + res[7], res[2] + res[5] + l };
-        }
+    if (!physx.empty())
+    {
+        out.translated = &physx.data()->x, out.translatedstride = 3;
+        out.offset[0] = offset.x, out.offset[1] = offset.y, out.offset[2] = offset.z;
+    }
 
-        {
-            __m256 t0x = _mm256_set1_ps(bt0.x);
-            __m256 t0y = _mm256_set1_ps(bt0.y);
-            __m256 t0z = _mm256_set1_ps(bt0.z);
-            __m256 t1x = _mm256_set1_ps(bt1.x);
-            __m256 t1y = _mm256_set1_ps(bt1.y);
-            __m256 t1z = _mm256_set1_ps(bt1.z);
+    return out;
+}
+}
 
-            __m256 t2 = _mm256_setr_ps(dt2.x, dt2.x, dt2.x, dt2.y, dt2.y, dt2.y, dt2.z, dt2.z);
+std::vector<geometry::vertex> bulkevaluate(beziervolume<2> const& v, std::vector<geometry::vertex> const& vertices)
+{
+    return bulkevaluate(v, vertexsoa(vertices));
+}
 
-            __m256 r0b1 = _mm256_fmadd_ps(t0x, v00, _mm256_fmadd_ps(t0y, v10, _mm256_mul_ps(t0z, v20)));
-            __m256 r1b1 = _mm256_fmadd_ps(t0x, v01, _mm256_fmadd_ps(t0y, v11, _mm256_mul_ps(t0z, v21)));
-            __m256 r2b1 = _mm256_fmadd_ps(t0x, v02, _mm256_fmadd_ps(t0y, v12, _mm256_mul_ps(t0z, v22)));
+vertexsoa::vertexsoa(std::vector<geometry::vertex> const& vertices) : count(vertices.size())
+{
+    // padding lanes evaluate the center of the volume and are never written out
+    uint const padded = (count + width - 1) / width * width;
+    x.resize(padded, 0.5f), y.resize(padded, 0.5f), z.resize(padded, 0.5f);
+    nx.resize(padded, 0.f), ny.resize(padded, 1.f), nz.resize(padded, 0.f);
 
-            _mm256_store_ps(res, _mm256_mul_ps(t2, _mm256_fmadd_ps(t1x, r0b1, _mm256_fmadd_ps(t1y, r1b1, _mm256_mul_ps(t1z, r2b1)))));
+    for (uint i = 0; i < count; ++i)
+    {
+        auto const& vtx = vertices[i];
+        x[i] = vtx.position.x, y[i] = vtx.position.y, z[i] = vtx.position.z;
+        nx[i] = vtx.normal.x, ny[i] = vtx.normal.y, nz[i] = vtx.normal.z;
+    }
+}
 
-            float const l = dt2.z * (bt1.x * (v[18].z * bt0.x + v[19].z * bt0.y + v[20].z * bt0.z) + bt1.y * (v[21].z * bt0.x + v[22].z * bt0.y + v[23].z * bt0.z) + bt1.z * (v[24].z * bt0.x + v[25].z * bt0.y + v[26].z * bt0.z));
-            tn1 = vector3{ res[0] + res[3] + res[6], res[1] + res[4] + res[7], res[2] + res[5] + l };
-        }
+std::vector<geometry::vertex> bulkevaluate(beziervolume<2> const& v, vertexsoa const& vertices)
+{
+    std::vector<geometry::vertex> ret(vertices.size());
+    bulkevaluate(v, vertices, ret);
+    return ret;
+}
 
-        {
-            __m256 t0x = _mm256_set1_ps(bt0.x);
-            __m256 t0y = _mm256_set1_ps(bt0.y);
-            __m256 t0z = _mm256_set1_ps(bt0.z);
-            __m256 t1x = _mm256_set1_ps(dt1.x);
-            __m256 t1y = _mm256_set1_ps(dt1.y);
-            __m256 t1z = _mm256_set1_ps(dt1.z);
+void bulkevaluate(beziervolume<2> const& v, vertexsoa const& vertices, std::span<geometry::vertex> out, std::span<vector3> physx, vector3 const& offset)
+{
+    assert(out.size() == vertices.size() && (physx.empty() || physx.size() == vertices.size()));
+    kernels::active().bulkevaluate(&v[0].x, kernels::soainput(vertices), kernels::vertexoutput(out, physx, offset));
+}
 
-            __m256 t2 = _mm256_setr_ps(bt2.x, bt2.x, bt2.x, bt2.y, bt2.y, bt2.y, bt2.z, bt2.z);
+template<uint n>
+requires(n >= 1 && n <= kernels::maxdegree)
+void bulkevaluate(beziervolume<n> const& v, vertexsoa const& vertices, std::span<geometry::vertex> out, std::span<vector3> physx, vector3 const& offset)
+{
+    assert(out.size() == vertices.size() && (physx.empty() || physx.size() == vertices.size()));
+    kernels::active().volumes[n](&v[0].x, kernels::soainput(vertices), kernels::vertexoutput(out, physx, offset));
+}
 
-            __m256 r0b1 = _mm256_fmadd_ps(t0x, v00, _mm256_fmadd_ps(t0y, v10, _mm256_mul_ps(t0z, v20)));
-            __m256 r1b1 = _mm256_fmadd_ps(t0x, v01, _mm256_fmadd_ps(t0y, v11, _mm256_mul_ps(t0z, v21)));
-            __m256 r2b1 = _mm256_fmadd_ps(t0x, v02, _mm256_fmadd_ps(t0y, v12, _mm256_mul_ps(t0z, v22)));
+template void bulkevaluate<1>(beziervolume<1> const&, vertexsoa const&, std::span<geometry::vertex>, std::span<vector3>, vector3 const&);
+template void bulkevaluate<2>(beziervolume<2> const&, vertexsoa const&, std::span<geometry::vertex>, std::span<vector3>, vector3 const&);
+template void bulkevaluate<3>(beziervolume<3> const&, vertexsoa const&, std::span<geometry::vertex>, std::span<vector3>, vector3 const&);
+template void bulkevaluate<4>(beziervolume<4> const&, vertexsoa const&, std::span<geometry::vertex>, std::span<vector3>, vector3 const&);
 
-            _mm256_store_ps(res, _mm256_mul_ps(t2, _mm256_fmadd_ps(t1x, r0b1, _mm256_fmadd_ps(t1y, r1b1, _mm256_mul_ps(t1z, r2b1)))));
+weightcache::weightcache(vertexsoa const& vertices, weightstorage _storage) : storage(_storage), count(vertices.size())
+{
+    static constexpr uint w = kernels::blockwidth;
+    uint const numblocks = vertices.x.size() / w;
+    weights.resize(numblocks * blocksize(storage));
 
-            float const l = bt2.z * (dt1.x * (v[18].z * bt0.x + v[19].z * bt0.y + v[20].z * bt0.z) + dt1.y * (v[21].z * bt0.x + v[22].z * bt0.y + v[23].z * bt0.z) + dt1.z * (v[24].z * bt0.x + v[25].z * bt0.y + v[26].z * bt0.z));
-            tn2 = vector3{ res[0] + res[3] + res[6], res[1] + res[4] + res[7], res[2] + res[5] + l };
+    for (uint blk = 0; blk < numblocks; ++blk)
+    {
+        float* block = &weights[blk * blocksize(storage)];
+        for (uint l = 0; l < w; ++l)
+        {
+            uint const i = blk * w + l;
+
+            // axis order of the contractions, x then z then y
+            std::array<vector3, 3> const bt = { qbasis(vertices.x[i]), qbasis(vertices.z[i]), qbasis(vertices.y[i]) };
+            std::array<vector3, 3> const dt = { dqbasis(vertices.x[i]), dqbasis(vertices.z[i]), dqbasis(vertices.y[i]) };
+
+            if (storage == weightstorage::separable)
+            {
+                for (uint axis = 0; axis < 3; ++axis)
+                {
+                    float* axisweights = block + axis * 6 * w;
+                    axisweights[0 * w + l] = bt[axis].x, axisweights[1 * w + l] = bt[axis].y, axisweights[2 * w + l] = bt[axis].z;
+                    axisweights[3 * w + l] = dt[axis].x, axisweights[4 * w + l] = dt[axis].y, axisweights[5 * w + l] = dt[axis].z;
+                }
+            }
+            else if (storage == weightstorage::tensor)
+            {
+                auto const at = [](vector3 const& v, uint i) { return i == 0 ? v.x : (i == 1 ? v.y : v.z); };
+                for (uint j = 0; j < 27; ++j)
+                {
+                    uint const a = j % 3, b = (j / 3) % 3, k = j / 9;
+                    float const b0 = at(bt[0], a), b1 = at(bt[1], b), b2 = at(bt[2], k);
+                    float const d0 = at(dt[0], a), d1 = at(dt[1], b), d2 = at(dt[2], k);
+
+                    // position, then the partials along x, z and y
+                    block[(0 * 27 + j) * w + l] = b0 * b1 * b2;
+                    block[(1 * 27 + j) * w + l] = d0 * b1 * b2;
+                    block[(2 * 27 + j) * w + l] = b0 * d1 * b2;
+                    block[(3 * 27 + j) * w + l] = b0 * b1 * d2;
+                }
+            }
         }
-
-        ret.emplace_back(pos, vector3::TransformNormal(vtx.normal, matrix(tn0, tn1, tn2)).Normalized());
     }
+}
+
+uint weightcache::blocksize(weightstorage storage)
+{
+    static constexpr uint w = kernels::blockwidth;
+    if (storage == weightstorage::separable) return kernels::separablerows * w;
+    if (storage == weightstorage::tensor) return kernels::tensorrows * w;
+    return 0;
+}
 
+std::vector<geometry::vertex> bulkevaluate(beziervolume<2> const& v, vertexsoa const& vertices, weightcache const& weights)
+{
+    std::vector<geometry::vertex> ret(vertices.size());
+    bulkevaluate(v, vertices, weights, ret);
     return ret;
 }
 
+void bulkevaluate(beziervolume<2> const& v, vertexsoa const& vertices, weightcache const& weights, std::span<geometry::vertex> out, std::span<vector3> physx, vector3 const& offset)
+{
+    if (weights.storage == weightstorage::none)
+        return bulkevaluate(v, vertices, out, physx, offset);
+
+    assert(weights.size() == vertices.size());
+    assert(out.size() == vertices.size() && (physx.empty() || physx.size() == vertices.size()));
+    auto const& table = kernels::active();
+    auto const kernel = weights.storage == weightstorage::separable ? table.separable : table.tensor;
+    kernel(&v[0].x, weights.weights.data(), kernels::soainput(vertices), kernels::vertexoutput(out, physx, offset));
+}
+
 voleval evaluatefast(beziervolume<2> const& v, vector3 const& uwv)
 {
     auto const [t0, t2, t1] = uwv;
@@ -175,7 +174,14 @@ voleval evaluatefast(beziervolume<2> const& v, vector3 const& uwv)
     vector3 const dt1 = dqbasis(t1);
     vector3 const dt2 = dqbasis(t2);
 
+    auto const evaluate = [&v, kernel = kernels::active().evaluate](vector3 const& b0, vector3 const& b1, vector3 const& b2)
+    {
+        vector3 res;
+        kernel(&v[0].x, &b0.x, &b1.x, &b2.x, &res.x);
+        return res;
+    };
+
     // create orientation using partial derivates
-    return { evaluateavx2(v, bt0, bt1, bt2), matrix{ evaluateavx2(v, dt0, bt1, bt2).Normalized(), evaluateavx2(v, bt0, bt1, dt2).Normalized(), evaluateavx2(v, bt0, dt1, bt2).Normalized() } };
+    return { evaluate(bt0, bt1, bt2), matrix{ evaluate(dt0, bt1, bt2).Normalized(), evaluate(bt0, bt1, dt2).Normalized(), evaluate(bt0, dt1, bt2).Normalized() } };
 }
 }
\ No newline at end of file
@@ -2,8 +2,10 @@
 
 #include "stdx/stdx.h"
 #include "geocore.h"
+#include "beziermathskernels.h"
 #include "engine/engineutils.h"
 
+#include <span>
 #include <array>
 #include <vector>
 #include <utility>
@@ -12,6 +14,8 @@
 
 namespace beziermaths
 {
+using stdx::uint;
+
 using controlpoint = vector3;
 using curveeval = std::pair<vector3, vector3>;
 using voleval = std::pair<vector3, matrix>;
@@ -26,6 +30,16 @@ inline constexpr vector3 qbasis(float t)
 // quadratic bezier 1st derivative basis
 inline constexpr vector3 dqbasis(float t) { return vector3(2 * (t - 1.f), 2.f - 4 * t, 2 * t); };
 
+// bezier basis of any degree
+template<uint n>
+constexpr std::array<float, n + 1> bernstein(float t)
+{
+    std::array<float, n + 1> r;
+    for (uint i = 0; i <= n; ++i)
+        r[i] = kernels::binomials<n>.v[i] * stdx::pown(t, i) * stdx::pown(1.f - t, n - i);
+    return r;
+}
+
 template<uint n>
 struct beziercurve
 {
@@ -104,8 +118,8 @@ struct decasteljau
         {
             // bilinear interpolation to calculate subpatch controlnet
             auto const& idx = stdx::grididx<1>::from1d(n - 1, i);
-            subpatch.controlnet[i] = (patch[stdx::grididx<1>::to1d<n>(idx)] * (1.f - u) + patch[stdx::grididx<1>::to1d<n>(idx) + u0] * u) * (1.f - v)
-                + (patch[stdx::grididx<1>::to1d<n>(idx + u1)] * (1.f - u) + patch[stdx::grididx<1>::to1d<n>(idx) + u0 + u1] * u) * v;
+            subpatch.controlnet[i] = (patch[stdx::grididx<1>::to1d<n>(idx)] * (1.f - u) + patch[stdx::grididx<1>::to1d<n>(idx + u0)] * u) * (1.f - v)
+                + (patch[stdx::grididx<1>::to1d<n>(idx + u1)] * (1.f - u) + patch[stdx::grididx<1>::to1d<n>(idx + u0 + u1)] * u) * v;
         }
 
         return decasteljau<n - 1u, s>::surface(subpatch, uv);
@@ -116,7 +130,7 @@ struct decasteljau
         using cubeidx = stdx::grididx<2>;
         static constexpr auto u0 = cubeidx(100);
         static constexpr auto u1 = cubeidx(10);
-        static constexpr auto u2 = cubeidx(100);
+        static constexpr auto u2 = cubeidx(1);
 
         auto const [t0, t2, t1] = uvw;
         beziervolume<n - 1u> subvol;
@@ -173,9 +187,9 @@ template<uint n>
 constexpr geometry::vertex evaluate(beziersurface<n> const& vol, vector2 const& uv) 
 {
     auto const &square = decasteljau<n, 1>::surface(vol, uv);
-    controlpoint const& p00 = square[stdx::grididx<1>::to1d<1>(0)];
-    controlpoint const& p10 = square[stdx::grididx<1>::to1d<1>(10)];
-    controlpoint const& p01 = square[stdx::grididx<1>::to1d<1>(1)];
+    controlpoint const& p00 = square[stdx::grididx<1>::to1d<1>(stdx::grididx<1>(0))];
+    controlpoint const& p10 = square[stdx::grididx<1>::to1d<1>(stdx::grididx<1>(10))];
+    controlpoint const& p01 = square[stdx::grididx<1>::to1d<1>(stdx::grididx<1>(1))];
 
     return { decasteljau<1, 0>::surface(square, uv).controlnet[0], (p01 - p00).Cross(p10 - p00).Normalized() };
 };
@@ -184,13 +198,105 @@ template<uint n>
 requires(n >= 0)
 constexpr vector3 evaluate(beziervolume<n> const& vol, vector3 const& uwv) {  return decasteljau<n, 0>::volume(vol, uwv).controlnet[0]; };
 
+// contracts the control net with the basis one axis at a time instead of building the intermediate nets of decasteljau
 template<uint n>
 requires(n >= 0)
-constexpr vector3 evaluatefast(beziervolume<n> const& vol, vector3 const& uwv) { return decasteljau<n, 0>::volume(vol, uwv).controlnet[0]; };
+constexpr vector3 evaluatefast(beziervolume<n> const& vol, vector3 const& uwv)
+{
+    auto const [t0, t2, t1] = uwv;
+    auto const bt0 = bernstein<n>(t0), bt1 = bernstein<n>(t1), bt2 = bernstein<n>(t2);
+
+    vector3 res = {};
+    for (uint k = 0; k <= n; ++k)
+    {
+        vector3 plane = {};
+        for (uint b = 0; b <= n; ++b)
+        {
+            vector3 line = {};
+            for (uint a = 0; a <= n; ++a)
+                line += vol[a + (n + 1) * (b + (n + 1) * k)] * bt0[a];
+
+            plane += line * bt1[b];
+        }
+
+        res += plane * bt2[k];
+    }
+
+    return res;
+};
+
+// parametric coordinates and normals as structure of arrays, padded to a multiple of width so the vertical kernels need no scalar tail
+struct vertexsoa
+{
+    static constexpr uint width = kernels::blockwidth;
+
+    vertexsoa() = default;
+    vertexsoa(std::vector<geometry::vertex> const& vertices);
+
+    uint size() const { return count; }
+
+    uint count = 0;
+    std::vector<float> x, y, z;
+    std::vector<float> nx, ny, nz;
+};
+
+// how much of the bernstein evaluation of constant parametric coordinates is cached
+// separable keeps the basis and derivative values of each axis(72 bytes per vertex) and still does the contractions
+// tensor keeps the 27 weights of the position and of each partial(432 bytes per vertex), evaluation becomes a (4 * verts x 27).(27 x 3) product
+enum class weightstorage
+{
+    none,
+    separable,
+    tensor
+};
+
+// immutable once built, so bodies deformed with the same parametric coordinates can share one
+struct weightcache
+{
+    weightcache() = default;
+    weightcache(vertexsoa const& vertices, weightstorage storage);
+
+    uint size() const { return count; }
+    uint memory() const { return weights.size() * sizeof(float); }
+
+    // floats per block of vertexsoa::width vertices
+    static uint blocksize(weightstorage storage);
+
+    weightstorage storage = weightstorage::none;
+    uint count = 0;
+    std::vector<float> weights;
+};
 
 voleval evaluatefast(beziervolume<2> const& v, vector3 const& uwv);
 std::vector<geometry::vertex> bulkevaluate(beziervolume<2> const& v, std::vector<geometry::vertex> const& vertices);
 
+// evaluates position and jacobian of a simd register of vertices at once, one vertex per lane
+// the kernels are picked at runtime for the cpu, see simd::active
+std::vector<geometry::vertex> bulkevaluate(beziervolume<2> const& v, vertexsoa const& vertices);
+
+// same as above with the basis values read from the cache, weights must have been built from vertices
+std::vector<geometry::vertex> bulkevaluate(beziervolume<2> const& v, vertexsoa const& vertices, weightcache const& weights);
+
+// these write into caller storage in the same pass and allocate nothing, out has one vertex per input vertex
+// only positions and normals of out are written, physx is optional and gets the positions moved by offset
+void bulkevaluate(beziervolume<2> const& v, vertexsoa const& vertices, std::span<geometry::vertex> out, std::span<vector3> physx = {}, vector3 const& offset = {});
+void bulkevaluate(beziervolume<2> const& v, vertexsoa const& vertices, weightcache const& weights, std::span<geometry::vertex> out, std::span<vector3> physx = {}, vector3 const& offset = {});
+
+// any degree up to kernels::maxdegree, the basis of degree n is built from the binomials at compile time
+// quadratic volumes have the overloads above, bulkevaluate<2> is there to measure the generic kernel against them
+template<uint n>
+requires(n >= 1 && n <= kernels::maxdegree)
+void bulkevaluate(beziervolume<n> const& v, vertexsoa const& vertices, std::span<geometry::vertex> out, std::span<vector3> physx = {}, vector3 const& offset = {});
+
+template<uint n>
+requires(n >= 1 && n <= kernels::maxdegree)
+std::vector<geometry::vertex> bulkevaluate(beziervolume<n> const& v, vertexsoa const& vertices)
+{
+    std::vector<geometry::vertex> ret(vertices.size());
+    bulkevaluate<n>(v, vertices, ret);
+    return ret;
+}
+
 template<uint n>
 constexpr beziertriangle<n + 1> elevate(beziertriangle<n> const& patch)
 {
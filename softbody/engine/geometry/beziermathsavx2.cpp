@@ -0,0 +1,242 @@
+#include "beziermathsgeneric.h"
+
+#include <immintrin.h>
+
+// 8 vertices per register, this file is built with /arch:AVX2
+namespace
+{
+using stdx::uint;
+
+using namespace beziermaths::kernels;
+
+static constexpr uint width = 8;
+
+struct basis8
+{
+    __m256 v[3];
+};
+
+// position and partials of one coordinate for 8 vertices, partials are along x, z and y(the order of the contractions)
+struct contraction8
+{
+    __m256 pos, d0, d1, d2;
+};
+
+basis8 qbasis(__m256 t)
+{
+    __m256 const invt = _mm256_sub_ps(_mm256_set1_ps(1.f), t);
+    return { _mm256_mul_ps(invt, invt), _mm256_mul_ps(_mm256_set1_ps(2.f), _mm256_mul_ps(invt, t)), _mm256_mul_ps(t, t) };
+}
+
+basis8 dqbasis(__m256 t)
+{
+    __m256 const two = _mm256_set1_ps(2.f);
+    return { _mm256_mul_ps(two, _mm256_sub_ps(t, _mm256_set1_ps(1.f))), _mm256_fnmadd_ps(_mm256_set1_ps(4.f), t, two), _mm256_mul_ps(two, t) };
+}
+
+basis8 loadbasis(float const* row) { return { _mm256_loadu_ps(row), _mm256_loadu_ps(row + blockwidth), _mm256_loadu_ps(row + 2 * blockwidth) }; }
+
+// cps points to the coordinate being contracted in the first control point, control points are 3 floats apart
+contraction8 contract(float const* cps, basis8 const& bt0, basis8 const& dt0, basis8 const& bt1, basis8 const& dt1, basis8 const& bt2, basis8 const& dt2)
+{
+    __m256 const zero = _mm256_setzero_ps();
+    contraction8 r{ zero, zero, zero, zero };
+    for (uint k = 0; k < 3; ++k)
+    {
+        __m256 plane = zero, dplane0 = zero, dplane1 = zero;
+        for (uint b = 0; b < 3; ++b)
+        {
+            float const* line = cps + (k * 9 + b * 3) * 3;
+            __m256 const c0 = _mm256_broadcast_ss(line);
+            __m256 const c1 = _mm256_broadcast_ss(line + 3);
+            __m256 const c2 = _mm256_broadcast_ss(line + 6);
+
+            __m256 const l = _mm256_fmadd_ps(bt0.v[0], c0, _mm256_fmadd_ps(bt0.v[1], c1, _mm256_mul_ps(bt0.v[2], c2)));
+            __m256 const dl = _mm256_fmadd_ps(dt0.v[0], c0, _mm256_fmadd_ps(dt0.v[1], c1, _mm256_mul_ps(dt0.v[2], c2)));
+
+            plane = _mm256_fmadd_ps(bt1.v[b], l, plane);
+            dplane0 = _mm256_fmadd_ps(bt1.v[b], dl, dplane0);
+            dplane1 = _mm256_fmadd_ps(dt1.v[b], l, dplane1);
+        }
+
+        r.pos = _mm256_fmadd_ps(bt2.v[k], plane, r.pos);
+        r.d0 = _mm256_fmadd_ps(bt2.v[k], dplane0, r.d0);
+        r.d1 = _mm256_fmadd_ps(bt2.v[k], dplane1, r.d1);
+        r.d2 = _mm256_fmadd_ps(dt2.v[k], plane, r.d2);
+    }
+
+    return r;
+}
+
+void store(contraction8 const& cx, contraction8 const& cy, contraction8 const& cz, input const& in, uint first, output const& out)
+{
+    // transform the normal by the jacobian, d0, d2 and d1 are the partials along x, y and z
+    __m256 const nx = _mm256_loadu_ps(in.nx + first);
+    __m256 const ny = _mm256_loadu_ps(in.ny + first);
+    __m256 const nz = _mm256_loadu_ps(in.nz + first);
+    __m256 const tnx = _mm256_fmadd_ps(nx, cx.d0, _mm256_fmadd_ps(ny, cx.d2, _mm256_mul_ps(nz, cx.d1)));
+    __m256 const tny = _mm256_fmadd_ps(nx, cy.d0, _mm256_fmadd_ps(ny, cy.d2, _mm256_mul_ps(nz, cy.d1)));
+    __m256 const tnz = _mm256_fmadd_ps(nx, cz.d0, _mm256_fmadd_ps(ny, cz.d2, _mm256_mul_ps(nz, cz.d1)));
+
+    // zero length normals stay zero, like vector3::Normalized
+    __m256 const lensq = _mm256_fmadd_ps(tnx, tnx, _mm256_fmadd_ps(tny, tny, _mm256_mul_ps(tnz, tnz)));
+    __m256 const rclen = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(lensq)), _mm256_cmp_ps(lensq, _mm256_setzero_ps(), _CMP_GT_OQ));
+
+    alignas(32) float res[6][width];
+    _mm256_store_ps(res[0], cx.pos);
+    _mm256_store_ps(res[1], cy.pos);
+    _mm256_store_ps(res[2], cz.pos);
+    _mm256_store_ps(res[3], _mm256_mul_ps(tnx, rclen));
+    _mm256_store_ps(res[4], _mm256_mul_ps(tny, rclen));
+    _mm256_store_ps(res[5], _mm256_mul_ps(tnz, rclen));
+
+    uint const numlanes = in.count - first < width ? in.count - first : width;
+    for (uint l = 0; l < numlanes; ++l)
+    {
+        float* pos = out.positions + (first + l) * out.stride;
+        float* normal = out.normals + (first + l) * out.stride;
+        pos[0] = res[0][l], pos[1] = res[1][l], pos[2] = res[2][l];
+        normal[0] = res[3][l], normal[1] = res[4][l], normal[2] = res[5][l];
+
+        if (out.translated)
+        {
+            float* translated = out.translated + (first + l) * out.translatedstride;
+            translated[0] = res[0][l] + out.offset[0], translated[1] = res[1][l] + out.offset[1], translated[2] = res[2][l] + out.offset[2];
+        }
+    }
+}
+
+void bulkevaluate(float const* cps, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; i += width)
+    {
+        basis8 const bt0 = qbasis(_mm256_loadu_ps(in.x + i)), dt0 = dqbasis(_mm256_loadu_ps(in.x + i));
+        basis8 const bt1 = qbasis(_mm256_loadu_ps(in.z + i)), dt1 = dqbasis(_mm256_loadu_ps(in.z + i));
+        basis8 const bt2 = qbasis(_mm256_loadu_ps(in.y + i)), dt2 = dqbasis(_mm256_loadu_ps(in.y + i));
+
+        store(contract(cps, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 1, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 2, bt0, dt0, bt1, dt1, bt2, dt2), in, i, out);
+    }
+}
+
+void separable(float const* cps, float const* weights, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; i += width)
+    {
+        float const* block = weights + (i / blockwidth) * separablerows * blockwidth + i % blockwidth;
+        basis8 const bt0 = loadbasis(block), dt0 = loadbasis(block + 3 * blockwidth);
+        basis8 const bt1 = loadbasis(block + 6 * blockwidth), dt1 = loadbasis(block + 9 * blockwidth);
+        basis8 const bt2 = loadbasis(block + 12 * blockwidth), dt2 = loadbasis(block + 15 * blockwidth);
+
+        store(contract(cps, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 1, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 2, bt0, dt0, bt1, dt1, bt2, dt2), in, i, out);
+    }
+}
+
+// a (4 * 8 x 27).(27 x 3) product per 8 vertices, done as two halves so the accumulators stay in registers
+void tensor(float const* cps, float const* weights, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; i += width)
+    {
+        float const* block = weights + (i / blockwidth) * tensorrows * blockwidth + i % blockwidth;
+
+        contraction8 c[3];
+        for (uint half = 0; half < 2; ++half)
+        {
+            float const* w0 = block + (half * 2) * 27 * blockwidth;
+            float const* w1 = block + (half * 2 + 1) * 27 * blockwidth;
+
+            __m256 acc[2][3];
+            for (auto& e : acc) for (auto& a : e) a = _mm256_setzero_ps();
+
+            for (uint cp = 0; cp < 27; ++cp)
+            {
+                __m256 const a0 = _mm256_loadu_ps(w0 + cp * blockwidth);
+                __m256 const a1 = _mm256_loadu_ps(w1 + cp * blockwidth);
+                for (uint k = 0; k < 3; ++k)
+                {
+                    __m256 const p = _mm256_broadcast_ss(cps + cp * 3 + k);
+                    acc[0][k] = _mm256_fmadd_ps(a0, p, acc[0][k]);
+                    acc[1][k] = _mm256_fmadd_ps(a1, p, acc[1][k]);
+                }
+            }
+
+            for (uint k = 0; k < 3; ++k)
+            {
+                if (half == 0) c[k].pos = acc[0][k], c[k].d0 = acc[1][k];
+                else c[k].d1 = acc[0][k], c[k].d2 = acc[1][k];
+            }
+        }
+
+        store(c[0], c[1], c[2], in, i, out);
+    }
+}
+
+// a single point vectorized within itself, the 27 control points are packed horizontally
+void evaluate(float const* cps, float const* bt0, float const* bt1, float const* bt2, float* res)
+{
+    // literally vectorizes the following expression
+    // bt2.x * (bt1.x * (v[0] * bt0.x + v[1] * bt0.y + v[2] * bt0.z) + bt1.y * (v[3] * bt0.x + v[4] * bt0.y + v[5] * bt0.z) + bt1.z * (v[6] * bt0.x + v[7] * bt0.y + v[8] * bt0.z))
+    // + bt2.y * (bt1.x * (v[9] * bt0.x + v[10] * bt0.y + v[11] * bt0.z) + bt1.y * (v[12] * bt0.x + v[13] * bt0.y + v[14] * bt0.z) + bt1.z * (v[15] * bt0.x + v[16] * bt0.y + v[17] * bt0.z))
+    // + bt2.z * (bt1.x * (v[18] * bt0.x + v[19] * bt0.y + v[20] * bt0.z) + bt1.y * (v[21] * bt0.x + v[22] * bt0.y + v[23] * bt0.z) + bt1.z * (v[24] * bt0.x + v[25] * bt0.y + v[26] * bt0.z));
+    auto const v = [cps](uint i) { return cps + i * 3; };
+
+    // vab is line along 3rd dim. ab represent first two dims.
+    __m256 v00 = _mm256_setr_ps(v(0)[0], v(0)[1], v(0)[2], v(9)[0], v(9)[1], v(9)[2], v(18)[0], v(18)[1]);
+    __m256 v10 = _mm256_setr_ps(v(1)[0], v(1)[1], v(1)[2], v(10)[0], v(10)[1], v(10)[2], v(19)[0], v(19)[1]);
+    __m256 v20 = _mm256_setr_ps(v(2)[0], v(2)[1], v(2)[2], v(11)[0], v(11)[1], v(11)[2], v(20)[0], v(20)[1]);
+
+    __m256 v01 = _mm256_setr_ps(v(3)[0], v(3)[1], v(3)[2], v(12)[0], v(12)[1], v(12)[2], v(21)[0], v(21)[1]);
+    __m256 v11 = _mm256_setr_ps(v(4)[0], v(4)[1], v(4)[2], v(13)[0], v(13)[1], v(13)[2], v(22)[0], v(22)[1]);
+    __m256 v21 = _mm256_setr_ps(v(5)[0], v(5)[1], v(5)[2], v(14)[0], v(14)[1], v(14)[2], v(23)[0], v(23)[1]);
+
+    __m256 v02 = _mm256_setr_ps(v(6)[0], v(6)[1], v(6)[2], v(15)[0], v(15)[1], v(15)[2], v(24)[0], v(24)[1]);
+    __m256 v12 = _mm256_setr_ps(v(7)[0], v(7)[1], v(7)[2], v(16)[0], v(16)[1], v(16)[2], v(25)[0], v(25)[1]);
+    __m256 v22 = _mm256_setr_ps(v(8)[0], v(8)[1], v(8)[2], v(17)[0], v(17)[1], v(17)[2], v(26)[0], v(26)[1]);
+
+    __m256 t0x = _mm256_set1_ps(bt0[0]);
+    __m256 t0y = _mm256_set1_ps(bt0[1]);
+    __m256 t0z = _mm256_set1_ps(bt0[2]);
+    __m256 t1x = _mm256_set1_ps(bt1[0]);
+    __m256 t1y = _mm256_set1_ps(bt1[1]);
+    __m256 t1z = _mm256_set1_ps(bt1[2]);
+
+    __m256 t2 = _mm256_setr_ps(bt2[0], bt2[0], bt2[0], bt2[1], bt2[1], bt2[1], bt2[2], bt2[2]);
+
+    // rnbx is plane with xth coordinate at n
+    __m256 r0b1 = _mm256_fmadd_ps(t0x, v00, _mm256_fmadd_ps(t0y, v10, _mm256_mul_ps(t0z, v20)));
+    __m256 r1b1 = _mm256_fmadd_ps(t0x, v01, _mm256_fmadd_ps(t0y, v11, _mm256_mul_ps(t0z, v21)));
+    __m256 r2b1 = _mm256_fmadd_ps(t0x, v02, _mm256_fmadd_ps(t0y, v12, _mm256_mul_ps(t0z, v22)));
+
+    alignas(32) float r[8];
+    _mm256_store_ps(r, _mm256_mul_ps(t2, _mm256_fmadd_ps(t1x, r0b1, _mm256_fmadd_ps(t1y, r1b1, _mm256_mul_ps(t1z, r2b1)))));
+
+    // compute the remaining value the scalar way
+    float const l = bt2[2] * (bt1[0] * (v(18)[2] * bt0[0] + v(19)[2] * bt0[1] + v(20)[2] * bt0[2]) + bt1[1] * (v(21)[2] * bt0[0] + v(22)[2] * bt0[1] + v(23)[2] * bt0[2]) + bt1[2] * (v(24)[2] * bt0[0] + v(25)[2] * bt0[1] + v(26)[2] * bt0[2]));
+    res[0] = r[0] + r[3] + r[6];
+    res[1] = r[1] + r[4] + r[7];
+    res[2] = r[2] + r[5] + l;
+}
+
+// register type and arithmetic of the generic kernels
+struct lanes
+{
+    using reg = __m256;
+    static constexpr uint width = 8;
+
+    static reg set1(float v) { return _mm256_set1_ps(v); }
+    static reg load(float const* src) { return _mm256_loadu_ps(src); }
+    static void store(float* dst, reg v) { _mm256_store_ps(dst, v); }
+    static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg madd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+    static reg rcplength(reg lensq) { return _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(lensq)), _mm256_cmp_ps(lensq, _mm256_setzero_ps(), _CMP_GT_OQ)); }
+};
+}
+
+namespace beziermaths::kernels
+{
+table const& avx2()
+{
+    static table const t{ simd::isa::avx2, bulkevaluate, separable, tensor, evaluate, volumekernels<lanes>() };
+    return t;
+}
+}
@@ -0,0 +1,198 @@
+#include "beziermathsgeneric.h"
+
+#include <immintrin.h>
+
+// 16 vertices per register, this file is built with /arch:AVX512
+namespace
+{
+using stdx::uint;
+
+using namespace beziermaths::kernels;
+
+static constexpr uint width = 16;
+
+struct basis16
+{
+    __m512 v[3];
+};
+
+// position and partials of one coordinate for 16 vertices, partials are along x, z and y(the order of the contractions)
+struct contraction16
+{
+    __m512 pos, d0, d1, d2;
+};
+
+basis16 qbasis(__m512 t)
+{
+    __m512 const invt = _mm512_sub_ps(_mm512_set1_ps(1.f), t);
+    return { _mm512_mul_ps(invt, invt), _mm512_mul_ps(_mm512_set1_ps(2.f), _mm512_mul_ps(invt, t)), _mm512_mul_ps(t, t) };
+}
+
+basis16 dqbasis(__m512 t)
+{
+    __m512 const two = _mm512_set1_ps(2.f);
+    return { _mm512_mul_ps(two, _mm512_sub_ps(t, _mm512_set1_ps(1.f))), _mm512_fnmadd_ps(_mm512_set1_ps(4.f), t, two), _mm512_mul_ps(two, t) };
+}
+
+basis16 loadbasis(float const* row) { return { _mm512_loadu_ps(row), _mm512_loadu_ps(row + blockwidth), _mm512_loadu_ps(row + 2 * blockwidth) }; }
+
+// cps points to the coordinate being contracted in the first control point, control points are 3 floats apart
+contraction16 contract(float const* cps, basis16 const& bt0, basis16 const& dt0, basis16 const& bt1, basis16 const& dt1, basis16 const& bt2, basis16 const& dt2)
+{
+    __m512 const zero = _mm512_setzero_ps();
+    contraction16 r{ zero, zero, zero, zero };
+    for (uint k = 0; k < 3; ++k)
+    {
+        __m512 plane = zero, dplane0 = zero, dplane1 = zero;
+        for (uint b = 0; b < 3; ++b)
+        {
+            float const* line = cps + (k * 9 + b * 3) * 3;
+            __m512 const c0 = _mm512_set1_ps(line[0]);
+            __m512 const c1 = _mm512_set1_ps(line[3]);
+            __m512 const c2 = _mm512_set1_ps(line[6]);
+
+            __m512 const l = _mm512_fmadd_ps(bt0.v[0], c0, _mm512_fmadd_ps(bt0.v[1], c1, _mm512_mul_ps(bt0.v[2], c2)));
+            __m512 const dl = _mm512_fmadd_ps(dt0.v[0], c0, _mm512_fmadd_ps(dt0.v[1], c1, _mm512_mul_ps(dt0.v[2], c2)));
+
+            plane = _mm512_fmadd_ps(bt1.v[b], l, plane);
+            dplane0 = _mm512_fmadd_ps(bt1.v[b], dl, dplane0);
+            dplane1 = _mm512_fmadd_ps(dt1.v[b], l, dplane1);
+        }
+
+        r.pos = _mm512_fmadd_ps(bt2.v[k], plane, r.pos);
+        r.d0 = _mm512_fmadd_ps(bt2.v[k], dplane0, r.d0);
+        r.d1 = _mm512_fmadd_ps(bt2.v[k], dplane1, r.d1);
+        r.d2 = _mm512_fmadd_ps(dt2.v[k], plane, r.d2);
+    }
+
+    return r;
+}
+
+void store(contraction16 const& cx, contraction16 const& cy, contraction16 const& cz, input const& in, uint first, output const& out)
+{
+    // transform the normal by the jacobian, d0, d2 and d1 are the partials along x, y and z
+    __m512 const nx = _mm512_loadu_ps(in.nx + first);
+    __m512 const ny = _mm512_loadu_ps(in.ny + first);
+    __m512 const nz = _mm512_loadu_ps(in.nz + first);
+    __m512 const tnx = _mm512_fmadd_ps(nx, cx.d0, _mm512_fmadd_ps(ny, cx.d2, _mm512_mul_ps(nz, cx.d1)));
+    __m512 const tny = _mm512_fmadd_ps(nx, cy.d0, _mm512_fmadd_ps(ny, cy.d2, _mm512_mul_ps(nz, cy.d1)));
+    __m512 const tnz = _mm512_fmadd_ps(nx, cz.d0, _mm512_fmadd_ps(ny, cz.d2, _mm512_mul_ps(nz, cz.d1)));
+
+    // zero length normals stay zero, like vector3::Normalized
+    __m512 const lensq = _mm512_fmadd_ps(tnx, tnx, _mm512_fmadd_ps(tny, tny, _mm512_mul_ps(tnz, tnz)));
+    __mmask16 const nonzero = _mm512_cmp_ps_mask(lensq, _mm512_setzero_ps(), _CMP_GT_OQ);
+    __m512 const rclen = _mm512_maskz_div_ps(nonzero, _mm512_set1_ps(1.f), _mm512_sqrt_ps(lensq));
+
+    alignas(64) float res[6][width];
+    _mm512_store_ps(res[0], cx.pos);
+    _mm512_store_ps(res[1], cy.pos);
+    _mm512_store_ps(res[2], cz.pos);
+    _mm512_store_ps(res[3], _mm512_mul_ps(tnx, rclen));
+    _mm512_store_ps(res[4], _mm512_mul_ps(tny, rclen));
+    _mm512_store_ps(res[5], _mm512_mul_ps(tnz, rclen));
+
+    uint const numlanes = in.count - first < width ? in.count - first : width;
+    for (uint l = 0; l < numlanes; ++l)
+    {
+        float* pos = out.positions + (first + l) * out.stride;
+        float* normal = out.normals + (first + l) * out.stride;
+        pos[0] = res[0][l], pos[1] = res[1][l], pos[2] = res[2][l];
+        normal[0] = res[3][l], normal[1] = res[4][l], normal[2] = res[5][l];
+
+        if (out.translated)
+        {
+            float* translated = out.translated + (first + l) * out.translatedstride;
+            translated[0] = res[0][l] + out.offset[0], translated[1] = res[1][l] + out.offset[1], translated[2] = res[2][l] + out.offset[2];
+        }
+    }
+}
+
+void bulkevaluate(float const* cps, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; i += width)
+    {
+        basis16 const bt0 = qbasis(_mm512_loadu_ps(in.x + i)), dt0 = dqbasis(_mm512_loadu_ps(in.x + i));
+        basis16 const bt1 = qbasis(_mm512_loadu_ps(in.z + i)), dt1 = dqbasis(_mm512_loadu_ps(in.z + i));
+        basis16 const bt2 = qbasis(_mm512_loadu_ps(in.y + i)), dt2 = dqbasis(_mm512_loadu_ps(in.y + i));
+
+        store(contract(cps, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 1, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 2, bt0, dt0, bt1, dt1, bt2, dt2), in, i, out);
+    }
+}
+
+void separable(float const* cps, float const* weights, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; i += width)
+    {
+        float const* block = weights + (i / blockwidth) * separablerows * blockwidth + i % blockwidth;
+        basis16 const bt0 = loadbasis(block), dt0 = loadbasis(block + 3 * blockwidth);
+        basis16 const bt1 = loadbasis(block + 6 * blockwidth), dt1 = loadbasis(block + 9 * blockwidth);
+        basis16 const bt2 = loadbasis(block + 12 * blockwidth), dt2 = loadbasis(block + 15 * blockwidth);
+
+        store(contract(cps, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 1, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 2, bt0, dt0, bt1, dt1, bt2, dt2), in, i, out);
+    }
+}
+
+// a (4 * 16 x 27).(27 x 3) product per 16 vertices, done as two halves so the accumulators stay in registers
+void tensor(float const* cps, float const* weights, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; i += width)
+    {
+        float const* block = weights + (i / blockwidth) * tensorrows * blockwidth + i % blockwidth;
+
+        contraction16 c[3];
+        for (uint half = 0; half < 2; ++half)
+        {
+            float const* w0 = block + (half * 2) * 27 * blockwidth;
+            float const* w1 = block + (half * 2 + 1) * 27 * blockwidth;
+
+            __m512 acc[2][3];
+            for (auto& e : acc) for (auto& a : e) a = _mm512_setzero_ps();
+
+            for (uint cp = 0; cp < 27; ++cp)
+            {
+                __m512 const a0 = _mm512_loadu_ps(w0 + cp * blockwidth);
+                __m512 const a1 = _mm512_loadu_ps(w1 + cp * blockwidth);
+                for (uint k = 0; k < 3; ++k)
+                {
+                    __m512 const p = _mm512_set1_ps(cps[cp * 3 + k]);
+                    acc[0][k] = _mm512_fmadd_ps(a0, p, acc[0][k]);
+                    acc[1][k] = _mm512_fmadd_ps(a1, p, acc[1][k]);
+                }
+            }
+
+            for (uint k = 0; k < 3; ++k)
+            {
+                if (half == 0) c[k].pos = acc[0][k], c[k].d0 = acc[1][k];
+                else c[k].d1 = acc[0][k], c[k].d2 = acc[1][k];
+            }
+        }
+
+        store(c[0], c[1], c[2], in, i, out);
+    }
+}
+
+// register type and arithmetic of the generic kernels
+struct lanes
+{
+    using reg = __m512;
+    static constexpr uint width = 16;
+
+    static reg set1(float v) { return _mm512_set1_ps(v); }
+    static reg load(float const* src) { return _mm512_loadu_ps(src); }
+    static void store(float* dst, reg v) { _mm512_store_ps(dst, v); }
+    static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg madd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static reg rcplength(reg lensq) { return _mm512_maskz_div_ps(_mm512_cmp_ps_mask(lensq, _mm512_setzero_ps(), _CMP_GT_OQ), _mm512_set1_ps(1.f), _mm512_sqrt_ps(lensq)); }
+};
+}
+
+namespace beziermaths::kernels
+{
+// single points do not fill 16 lanes, they use the avx2 kernel
+table const& avx512()
+{
+    static table const t{ simd::isa::avx512, bulkevaluate, separable, tensor, avx2().evaluate, volumekernels<lanes>() };
+    return t;
+}
+}
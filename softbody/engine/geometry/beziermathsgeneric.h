@@ -0,0 +1,151 @@
+#pragma once
+
+#include "beziermathskernels.h"
+
+#include <utility>
+
+// volume kernels of any degree written once over a lane type, included by the per instruction set translation units
+// lanes provides the register type and its arithmetic, each translation unit declares it in an unnamed namespace
+// so the instantiations stay local to the translation unit and its instruction set
+namespace beziermaths::kernels
+{
+using stdx::uint;
+
+template<typename lanes, uint n>
+requires (n >= 1)
+struct volumekernel
+{
+    using reg = typename lanes::reg;
+    static constexpr uint order = n + 1;
+
+    struct basis
+    {
+        reg v[order];
+    };
+
+    // position and partials of one coordinate, partials are along x, z and y(the order of the contractions)
+    struct contraction
+    {
+        reg pos, d0, d1, d2;
+    };
+
+    // bernstein basis of degree n and its derivative, d/dt b(n, i) = n * (b(n - 1, i - 1) - b(n - 1, i))
+    static void bases(reg t, basis& b, basis& d)
+    {
+        reg const one = lanes::set1(1.f);
+        reg const invt = lanes::sub(one, t);
+
+        // powers of t and 1 - t, shared by both bases
+        reg pt[order], pinvt[order];
+        pt[0] = pinvt[0] = one;
+        for (uint i = 1; i < order; ++i)
+        {
+            pt[i] = lanes::mul(pt[i - 1], t);
+            pinvt[i] = lanes::mul(pinvt[i - 1], invt);
+        }
+
+        for (uint i = 0; i < order; ++i)
+            b.v[i] = lanes::mul(lanes::set1(binomials<n>.v[i]), lanes::mul(pt[i], pinvt[n - i]));
+
+        reg lower[n];
+        for (uint i = 0; i < n; ++i)
+            lower[i] = lanes::mul(lanes::set1(binomials<n - 1>.v[i] * float(n)), lanes::mul(pt[i], pinvt[n - 1 - i]));
+
+        d.v[0] = lanes::sub(lanes::set1(0.f), lower[0]);
+        for (uint i = 1; i < n; ++i)
+            d.v[i] = lanes::sub(lower[i - 1], lower[i]);
+        d.v[n] = lower[n - 1];
+    }
+
+    // one line of control points along x, expanded at compile time so it does not depend on the optimizer unrolling it
+    template<uint... a>
+    static void contractline(float const* line, basis const& bt0, basis const& dt0, reg& l, reg& dl, std::integer_sequence<uint, a...>)
+    {
+        reg const c[] = { lanes::set1(line[a * 3])... };
+        ((l = lanes::madd(bt0.v[a], c[a], l), dl = lanes::madd(dt0.v[a], c[a], dl)), ...);
+    }
+
+    // cps points to the coordinate being contracted in the first control point, control points are 3 floats apart
+    static contraction contract(float const* cps, basis const& bt0, basis const& dt0, basis const& bt1, basis const& dt1, basis const& bt2, basis const& dt2)
+    {
+        reg const zero = lanes::set1(0.f);
+        contraction r{ zero, zero, zero, zero };
+        for (uint k = 0; k < order; ++k)
+        {
+            reg plane = zero, dplane0 = zero, dplane1 = zero;
+            for (uint b = 0; b < order; ++b)
+            {
+                reg l = zero, dl = zero;
+                contractline(cps + (k * order + b) * order * 3, bt0, dt0, l, dl, std::make_integer_sequence<uint, order>{});
+
+                plane = lanes::madd(bt1.v[b], l, plane);
+                dplane0 = lanes::madd(bt1.v[b], dl, dplane0);
+                dplane1 = lanes::madd(dt1.v[b], l, dplane1);
+            }
+
+            r.pos = lanes::madd(bt2.v[k], plane, r.pos);
+            r.d0 = lanes::madd(bt2.v[k], dplane0, r.d0);
+            r.d1 = lanes::madd(bt2.v[k], dplane1, r.d1);
+            r.d2 = lanes::madd(dt2.v[k], plane, r.d2);
+        }
+
+        return r;
+    }
+
+    static void store(contraction const& cx, contraction const& cy, contraction const& cz, input const& in, uint first, output const& out)
+    {
+        // d0, d2 and d1 are the partials along x, y and z
+        reg const nx = lanes::load(in.nx + first);
+        reg const ny = lanes::load(in.ny + first);
+        reg const nz = lanes::load(in.nz + first);
+        reg const tnx = lanes::madd(nx, cx.d0, lanes::madd(ny, cx.d2, lanes::mul(nz, cx.d1)));
+        reg const tny = lanes::madd(nx, cy.d0, lanes::madd(ny, cy.d2, lanes::mul(nz, cy.d1)));
+        reg const tnz = lanes::madd(nx, cz.d0, lanes::madd(ny, cz.d2, lanes::mul(nz, cz.d1)));
+        reg const rclen = lanes::rcplength(lanes::madd(tnx, tnx, lanes::madd(tny, tny, lanes::mul(tnz, tnz))));
+
+        alignas(64) float res[6][lanes::width];
+        lanes::store(res[0], cx.pos);
+        lanes::store(res[1], cy.pos);
+        lanes::store(res[2], cz.pos);
+        lanes::store(res[3], lanes::mul(tnx, rclen));
+        lanes::store(res[4], lanes::mul(tny, rclen));
+        lanes::store(res[5], lanes::mul(tnz, rclen));
+
+        uint const numlanes = in.count - first < lanes::width ? in.count - first : lanes::width;
+        for (uint l = 0; l < numlanes; ++l)
+        {
+            float* pos = out.positions + (first + l) * out.stride;
+            float* normal = out.normals + (first + l) * out.stride;
+            pos[0] = res[0][l], pos[1] = res[1][l], pos[2] = res[2][l];
+            normal[0] = res[3][l], normal[1] = res[4][l], normal[2] = res[5][l];
+
+            if (out.translated)
+            {
+                float* translated = out.translated + (first + l) * out.translatedstride;
+                translated[0] = res[0][l] + out.offset[0], translated[1] = res[1][l] + out.offset[1], translated[2] = res[2][l] + out.offset[2];
+            }
+        }
+    }
+
+    static void bulkevaluate(float const* cps, input const& in, output const& out)
+    {
+        for (uint i = 0; i < in.count; i += lanes::width)
+        {
+            basis bt0, dt0, bt1, dt1, bt2, dt2;
+            bases(lanes::load(in.x + i), bt0, dt0);
+            bases(lanes::load(in.z + i), bt1, dt1);
+            bases(lanes::load(in.y + i), bt2, dt2);
+
+            store(contract(cps, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 1, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 2, bt0, dt0, bt1, dt1, bt2, dt2), in, i, out);
+        }
+    }
+};
+
+// table::volumes, degree 0 has no kernel
+template<typename lanes>
+constexpr std::array<volume_fn, maxdegree + 1> volumekernels()
+{
+    static_assert(maxdegree == 4, "add the new degrees below");
+    return { nullptr, volumekernel<lanes, 1>::bulkevaluate, volumekernel<lanes, 2>::bulkevaluate, volumekernel<lanes, 3>::bulkevaluate, volumekernel<lanes, 4>::bulkevaluate };
+}
+}
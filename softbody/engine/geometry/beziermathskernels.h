@@ -0,0 +1,92 @@
+#pragma once
+
+#include "stdx/stdxcore.h"
+#include "engine/simd.h"
+
+#include <array>
+
+// raw kernels behind the beziermaths bulk evaluators, one table per instruction set
+namespace beziermaths::kernels
+{
+using stdx::uint;
+
+// lanes per block of the padded inputs and of the weight caches, the widest simd width
+inline constexpr uint blockwidth = 16;
+
+// rows of blockwidth floats per block of a weight cache
+// separable : basis and derivative values of the x, z and y axes
+// tensor : the 27 weights of the position and of the partials along x, z and y
+inline constexpr uint separablerows = 3 * 6;
+inline constexpr uint tensorrows = 4 * 27;
+
+// highest degree with a bulk volume kernel
+inline constexpr uint maxdegree = 4;
+
+// row n of pascal's triangle, a plain array so kernels built for wider instruction sets call no shared inline code
+template<uint n>
+struct binomialrow
+{
+    float v[n + 1] = {};
+
+    constexpr binomialrow()
+    {
+        v[0] = 1.f;
+        for (uint i = 1; i <= n; ++i)
+            v[i] = v[i - 1] * float(n - i + 1) / float(i);
+    }
+};
+
+template<uint n>
+inline constexpr binomialrow<n> binomials{};
+
+// parametric coordinates and normals as structure of arrays, padded to a multiple of blockwidth
+struct input
+{
+    float const* x;
+    float const* y;
+    float const* z;
+    float const* nx;
+    float const* ny;
+    float const* nz;
+    uint count;
+};
+
+// vertex i writes its position and normal at i * stride
+// translated is optional, vertex i writes its position moved by offset at i * translatedstride
+struct output
+{
+    float* positions;
+    float* normals;
+    uint stride;
+    float* translated = nullptr;
+    uint translatedstride = 0;
+    float offset[3] = {};
+};
+
+// controlpoints are the (n + 1)^3 control points of a volume of degree n, 27 for the quadratic kernels
+using volume_fn = void(*)(float const* controlpoints, input const& in, output const& out);
+using volume2cached_fn = void(*)(float const* controlpoints, float const* weights, input const& in, output const& out);
+
+// one point from its basis values, res gets 3 floats
+using point2_fn = void(*)(float const* controlpoints, float const* bt0, float const* bt1, float const* bt2, float* res);
+
+struct table
+{
+    simd::isa isa;
+    volume_fn bulkevaluate;
+    volume2cached_fn separable;
+    volume2cached_fn tensor;
+    point2_fn evaluate;
+
+    // generic kernels indexed by degree, the quadratic one is kept to measure it against bulkevaluate
+    std::array<volume_fn, maxdegree + 1> volumes;
+};
+
+table const& scalar();
+table const& sse4();
+table const& avx2();
+table const& avx512();
+
+// table for simd::active()
+table const& active();
+}
@@ -0,0 +1,168 @@
+#include "beziermathsgeneric.h"
+
+#include <cmath>
+
+// portable fallback, softbody_bench_beziermaths checks it and the simd tables against the same double precision reference
+namespace
+{
+using stdx::uint;
+
+using namespace beziermaths::kernels;
+
+using basis = float[3];
+
+// position and partials along x, z and y(the order of the contractions) of the three coordinates
+struct jacobian
+{
+    float pos[3] = {}, d0[3] = {}, d1[3] = {}, d2[3] = {};
+};
+
+void qbasis(float t, basis& b)
+{
+    float const invt = 1.f - t;
+    b[0] = invt * invt, b[1] = 2.f * invt * t, b[2] = t * t;
+}
+
+void dqbasis(float t, basis& b) { b[0] = 2.f * (t - 1.f), b[1] = 2.f - 4.f * t, b[2] = 2.f * t; }
+
+jacobian contract(float const* cps, basis const& bt0, basis const& dt0, basis const& bt1, basis const& dt1, basis const& bt2, basis const& dt2)
+{
+    jacobian r;
+    for (uint k = 0; k < 3; ++k)
+    {
+        float plane[3] = {}, dplane0[3] = {}, dplane1[3] = {};
+        for (uint b = 0; b < 3; ++b)
+        {
+            float const* line = cps + (k * 9 + b * 3) * 3;
+            for (uint c = 0; c < 3; ++c)
+            {
+                float const l = bt0[0] * line[c] + bt0[1] * line[3 + c] + bt0[2] * line[6 + c];
+                float const dl = dt0[0] * line[c] + dt0[1] * line[3 + c] + dt0[2] * line[6 + c];
+                plane[c] += bt1[b] * l;
+                dplane0[c] += bt1[b] * dl;
+                dplane1[c] += dt1[b] * l;
+            }
+        }
+
+        for (uint c = 0; c < 3; ++c)
+        {
+            r.pos[c] += bt2[k] * plane[c];
+            r.d0[c] += bt2[k] * dplane0[c];
+            r.d1[c] += bt2[k] * dplane1[c];
+            r.d2[c] += dt2[k] * plane[c];
+        }
+    }
+
+    return r;
+}
+
+void store(jacobian const& j, input const& in, uint i, output const& out)
+{
+    // transform the normal by the jacobian, d0, d2 and d1 are the partials along x, y and z
+    float tn[3];
+    for (uint c = 0; c < 3; ++c)
+        tn[c] = in.nx[i] * j.d0[c] + in.ny[i] * j.d2[c] + in.nz[i] * j.d1[c];
+
+    float const lensq = tn[0] * tn[0] + tn[1] * tn[1] + tn[2] * tn[2];
+    float const rclen = lensq > 0.f ? 1.f / std::sqrt(lensq) : 0.f;
+
+    float* pos = out.positions + i * out.stride;
+    float* normal = out.normals + i * out.stride;
+    for (uint c = 0; c < 3; ++c)
+    {
+        pos[c] = j.pos[c];
+        normal[c] = tn[c] * rclen;
+    }
+
+    if (out.translated)
+    {
+        float* translated = out.translated + i * out.translatedstride;
+        for (uint c = 0; c < 3; ++c)
+            translated[c] = j.pos[c] + out.offset[c];
+    }
+}
+
+void bulkevaluate(float const* cps, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; ++i)
+    {
+        basis bt0, dt0, bt1, dt1, bt2, dt2;
+        qbasis(in.x[i], bt0), dqbasis(in.x[i], dt0);
+        qbasis(in.z[i], bt1), dqbasis(in.z[i], dt1);
+        qbasis(in.y[i], bt2), dqbasis(in.y[i], dt2);
+
+        store(contract(cps, bt0, dt0, bt1, dt1, bt2, dt2), in, i, out);
+    }
+}
+
+void separable(float const* cps, float const* weights, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; ++i)
+    {
+        float const* block = weights + (i / blockwidth) * separablerows * blockwidth + i % blockwidth;
+        auto const load = [block](uint row, basis& b) { b[0] = block[row * blockwidth], b[1] = block[(row + 1) * blockwidth], b[2] = block[(row + 2) * blockwidth]; };
+
+        basis bt0, dt0, bt1, dt1, bt2, dt2;
+        load(0, bt0), load(3, dt0);
+        load(6, bt1), load(9, dt1);
+        load(12, bt2), load(15, dt2);
+
+        store(contract(cps, bt0, dt0, bt1, dt1, bt2, dt2), in, i, out);
+    }
+}
+
+void tensor(float const* cps, float const* weights, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; ++i)
+    {
+        float const* block = weights + (i / blockwidth) * tensorrows * blockwidth + i % blockwidth;
+
+        jacobian j;
+        float* const evals[4] = { j.pos, j.d0, j.d1, j.d2 };
+        for (uint e = 0; e < 4; ++e)
+            for (uint cp = 0; cp < 27; ++cp)
+            {
+                float const w = block[(e * 27 + cp) * blockwidth];
+                for (uint c = 0; c < 3; ++c)
+                    evals[e][c] += w * cps[cp * 3 + c];
+            }
+
+        store(j, in, i, out);
+    }
+}
+
+void evaluate(float const* cps, float const* bt0, float const* bt1, float const* bt2, float* res)
+{
+    res[0] = res[1] = res[2] = 0.f;
+    for (uint cp = 0; cp < 27; ++cp)
+    {
+        float const w = bt0[cp % 3] * bt1[(cp / 3) % 3] * bt2[cp / 9];
+        for (uint c = 0; c < 3; ++c)
+            res[c] += w * cps[cp * 3 + c];
+    }
+}
+
+// one vertex per "register", the generic kernels
+struct lanes
+{
+    using reg = float;
+    static constexpr uint width = 1;
+
+    static reg set1(float v) { return v; }
+    static reg load(float const* src) { return *src; }
+    static void store(float* dst, reg v) { *dst = v; }
+    static reg sub(reg a, reg b) { return a - b; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg madd(reg a, reg b, reg c) { return a * b + c; }
+    static reg rcplength(reg lensq) { return lensq > 0.f ? 1.f / std::sqrt(lensq) : 0.f; }
+};
+}
+
+namespace beziermaths::kernels
+{
+table const& scalar()
+{
+    static table const t{ simd::isa::scalar, bulkevaluate, separable, tensor, evaluate, volumekernels<lanes>() };
+    return t;
+}
+}
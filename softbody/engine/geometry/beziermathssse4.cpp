@@ -0,0 +1,186 @@
+#include "beziermathsgeneric.h"
+
+#include <smmintrin.h>
+
+// 4 vertices per register, there is no fma before avx2 so products and sums are separate
+namespace
+{
+using stdx::uint;
+
+using namespace beziermaths::kernels;
+
+static constexpr uint width = 4;
+
+struct basis4
+{
+    __m128 v[3];
+};
+
+// position and partials of one coordinate, partials are along x, z and y(the order of the contractions)
+struct contraction4
+{
+    __m128 pos, d0, d1, d2;
+};
+
+__m128 madd(__m128 a, __m128 b, __m128 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+basis4 qbasis(__m128 t)
+{
+    __m128 const invt = _mm_sub_ps(_mm_set1_ps(1.f), t);
+    return { _mm_mul_ps(invt, invt), _mm_mul_ps(_mm_set1_ps(2.f), _mm_mul_ps(invt, t)), _mm_mul_ps(t, t) };
+}
+
+basis4 dqbasis(__m128 t)
+{
+    __m128 const two = _mm_set1_ps(2.f);
+    return { _mm_mul_ps(two, _mm_sub_ps(t, _mm_set1_ps(1.f))), _mm_sub_ps(two, _mm_mul_ps(_mm_set1_ps(4.f), t)), _mm_mul_ps(two, t) };
+}
+
+basis4 loadbasis(float const* row) { return { _mm_loadu_ps(row), _mm_loadu_ps(row + blockwidth), _mm_loadu_ps(row + 2 * blockwidth) }; }
+
+// cps points to the coordinate being contracted in the first control point, control points are 3 floats apart
+contraction4 contract(float const* cps, basis4 const& bt0, basis4 const& dt0, basis4 const& bt1, basis4 const& dt1, basis4 const& bt2, basis4 const& dt2)
+{
+    __m128 const zero = _mm_setzero_ps();
+    contraction4 r{ zero, zero, zero, zero };
+    for (uint k = 0; k < 3; ++k)
+    {
+        __m128 plane = zero, dplane0 = zero, dplane1 = zero;
+        for (uint b = 0; b < 3; ++b)
+        {
+            float const* line = cps + (k * 9 + b * 3) * 3;
+            __m128 const c0 = _mm_set1_ps(line[0]);
+            __m128 const c1 = _mm_set1_ps(line[3]);
+            __m128 const c2 = _mm_set1_ps(line[6]);
+
+            __m128 const l = madd(bt0.v[0], c0, madd(bt0.v[1], c1, _mm_mul_ps(bt0.v[2], c2)));
+            __m128 const dl = madd(dt0.v[0], c0, madd(dt0.v[1], c1, _mm_mul_ps(dt0.v[2], c2)));
+
+            plane = madd(bt1.v[b], l, plane);
+            dplane0 = madd(bt1.v[b], dl, dplane0);
+            dplane1 = madd(dt1.v[b], l, dplane1);
+        }
+
+        r.pos = madd(bt2.v[k], plane, r.pos);
+        r.d0 = madd(bt2.v[k], dplane0, r.d0);
+        r.d1 = madd(bt2.v[k], dplane1, r.d1);
+        r.d2 = madd(dt2.v[k], plane, r.d2);
+    }
+
+    return r;
+}
+
+void store(contraction4 const& cx, contraction4 const& cy, contraction4 const& cz, input const& in, uint first, output const& out)
+{
+    // d0, d2 and d1 are the partials along x, y and z
+    __m128 const nx = _mm_loadu_ps(in.nx + first);
+    __m128 const ny = _mm_loadu_ps(in.ny + first);
+    __m128 const nz = _mm_loadu_ps(in.nz + first);
+    __m128 const tnx = madd(nx, cx.d0, madd(ny, cx.d2, _mm_mul_ps(nz, cx.d1)));
+    __m128 const tny = madd(nx, cy.d0, madd(ny, cy.d2, _mm_mul_ps(nz, cy.d1)));
+    __m128 const tnz = madd(nx, cz.d0, madd(ny, cz.d2, _mm_mul_ps(nz, cz.d1)));
+
+    // zero length normals stay zero
+    __m128 const lensq = madd(tnx, tnx, madd(tny, tny, _mm_mul_ps(tnz, tnz)));
+    __m128 const rclen = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(lensq)), _mm_cmpgt_ps(lensq, _mm_setzero_ps()));
+
+    alignas(16) float res[6][width];
+    _mm_store_ps(res[0], cx.pos);
+    _mm_store_ps(res[1], cy.pos);
+    _mm_store_ps(res[2], cz.pos);
+    _mm_store_ps(res[3], _mm_mul_ps(tnx, rclen));
+    _mm_store_ps(res[4], _mm_mul_ps(tny, rclen));
+    _mm_store_ps(res[5], _mm_mul_ps(tnz, rclen));
+
+    uint const numlanes = in.count - first < width ? in.count - first : width;
+    for (uint l = 0; l < numlanes; ++l)
+    {
+        float* pos = out.positions + (first + l) * out.stride;
+        float* normal = out.normals + (first + l) * out.stride;
+        pos[0] = res[0][l], pos[1] = res[1][l], pos[2] = res[2][l];
+        normal[0] = res[3][l], normal[1] = res[4][l], normal[2] = res[5][l];
+
+        if (out.translated)
+        {
+            float* translated = out.translated + (first + l) * out.translatedstride;
+            translated[0] = res[0][l] + out.offset[0], translated[1] = res[1][l] + out.offset[1], translated[2] = res[2][l] + out.offset[2];
+        }
+    }
+}
+
+void bulkevaluate(float const* cps, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; i += width)
+    {
+        basis4 const bt0 = qbasis(_mm_loadu_ps(in.x + i)), dt0 = dqbasis(_mm_loadu_ps(in.x + i));
+        basis4 const bt1 = qbasis(_mm_loadu_ps(in.z + i)), dt1 = dqbasis(_mm_loadu_ps(in.z + i));
+        basis4 const bt2 = qbasis(_mm_loadu_ps(in.y + i)), dt2 = dqbasis(_mm_loadu_ps(in.y + i));
+
+        store(contract(cps, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 1, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 2, bt0, dt0, bt1, dt1, bt2, dt2), in, i, out);
+    }
+}
+
+void separable(float const* cps, float const* weights, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; i += width)
+    {
+        float const* block = weights + (i / blockwidth) * separablerows * blockwidth + i % blockwidth;
+        basis4 const bt0 = loadbasis(block), dt0 = loadbasis(block + 3 * blockwidth);
+        basis4 const bt1 = loadbasis(block + 6 * blockwidth), dt1 = loadbasis(block + 9 * blockwidth);
+        basis4 const bt2 = loadbasis(block + 12 * blockwidth), dt2 = loadbasis(block + 15 * blockwidth);
+
+        store(contract(cps, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 1, bt0, dt0, bt1, dt1, bt2, dt2), contract(cps + 2, bt0, dt0, bt1, dt1, bt2, dt2), in, i, out);
+    }
+}
+
+void tensor(float const* cps, float const* weights, input const& in, output const& out)
+{
+    for (uint i = 0; i < in.count; i += width)
+    {
+        float const* block = weights + (i / blockwidth) * tensorrows * blockwidth + i % blockwidth;
+
+        // one evaluation(position or a partial) at a time keeps the 3 accumulators and the weights in registers
+        contraction4 c[3];
+        __m128* const evals[4][3] = { { &c[0].pos, &c[1].pos, &c[2].pos }, { &c[0].d0, &c[1].d0, &c[2].d0 }, { &c[0].d1, &c[1].d1, &c[2].d1 }, { &c[0].d2, &c[1].d2, &c[2].d2 } };
+        for (uint e = 0; e < 4; ++e)
+        {
+            __m128 acc[3] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+            for (uint cp = 0; cp < 27; ++cp)
+            {
+                __m128 const w = _mm_loadu_ps(block + (e * 27 + cp) * blockwidth);
+                for (uint k = 0; k < 3; ++k)
+                    acc[k] = madd(w, _mm_set1_ps(cps[cp * 3 + k]), acc[k]);
+            }
+
+            for (uint k = 0; k < 3; ++k) *evals[e][k] = acc[k];
+        }
+
+        store(c[0], c[1], c[2], in, i, out);
+    }
+}
+
+// register type and arithmetic of the generic kernels
+struct lanes
+{
+    using reg = __m128;
+    static constexpr uint width = 4;
+
+    static reg set1(float v) { return _mm_set1_ps(v); }
+    static reg load(float const* src) { return _mm_loadu_ps(src); }
+    static void store(float* dst, reg v) { _mm_store_ps(dst, v); }
+    static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static reg madd(reg a, reg b, reg c) { return ::madd(a, b, c); }
+    static reg rcplength(reg lensq) { return _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(lensq)), _mm_cmpgt_ps(lensq, _mm_setzero_ps())); }
+};
+}
+
+namespace beziermaths::kernels
+{
+// single points have too little parallelism across 4 lanes, they use the scalar kernel
+table const& sse4()
+{
+    static table const t{ simd::isa::sse4, bulkevaluate, separable, tensor, scalar().evaluate, volumekernels<lanes>() };
+    return t;
+}
+}
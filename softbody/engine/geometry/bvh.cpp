@@ -0,0 +1,94 @@
+#include "bvh.h"
+
+#include <algorithm>
+
+using namespace geometry;
+
+namespace
+{
+    using stdx::uint;
+
+    struct buildtri
+    {
+        uint first;
+        vector3 centroid;
+        aabb box;
+    };
+
+    float axisof(vector3 const& v, uint axis) { return axis == 0 ? v.x : (axis == 1 ? v.y : v.z); }
+
+    // splits tris at the median centroid along the longest axis of the centroids' bounds, returns the node index
+    uint build(std::vector<trianglebvh::node>& nodes, std::vector<buildtri>& tris, uint first, uint count, uint depth)
+    {
+        assert(depth < trianglebvh::maxdepth);
+
+        uint const nodeidx = static_cast<uint>(nodes.size());
+        nodes.emplace_back();
+        if (count <= trianglebvh::leafsize)
+        {
+            nodes[nodeidx].first = first;
+            nodes[nodeidx].count = count;
+            return nodeidx;
+        }
+
+        aabb centroids{ tris[first].centroid, tris[first].centroid };
+        for (uint i = first + 1; i < first + count; ++i)
+            centroids += tris[i].centroid;
+
+        auto const span = centroids.span();
+        uint const axis = span.x >= span.y && span.x >= span.z ? 0 : (span.y >= span.z ? 1 : 2);
+
+        uint const half = count / 2;
+        std::nth_element(tris.begin() + first, tris.begin() + first + half, tris.begin() + first + count, [axis](buildtri const& l, buildtri const& r) { return axisof(l.centroid, axis) < axisof(r.centroid, axis); });
+
+        // nodes may reallocate while building the children
+        uint const left = build(nodes, tris, first, half, depth + 1);
+        uint const right = build(nodes, tris, first + half, count - half, depth + 1);
+        nodes[nodeidx].left = left;
+        nodes[nodeidx].right = right;
+        return nodeidx;
+    }
+}
+
+geometry::trianglebvh::trianglebvh(std::vector<vertex> const& vertices, std::vector<uint> const& indices)
+{
+    uint const numtris = static_cast<uint>(indices.size() / 3);
+    if (numtris == 0)
+        return;
+
+    std::vector<buildtri> buildtris;
+    buildtris.reserve(numtris);
+    for (uint i = 0; i < indices.size(); i += 3)
+    {
+        vector3 const tri[3] = { vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position };
+        buildtris.push_back({ i, (tri[0] + tri[1] + tri[2]) / 3.f, aabb{ tri } });
+    }
+
+    nodes.reserve(2 * numtris / leafsize + 1);
+    build(nodes, buildtris, 0, numtris, 0);
+
+    tris.reserve(numtris);
+    for (auto const& t : buildtris)
+        tris.push_back(t.first);
+}
+
+void geometry::trianglebvh::refit(std::vector<vector3> const& positions, std::vector<uint> const& indices, aabbsoa& triboxes, std::vector<aabb>& boxes) const
+{
+    triboxes.fromtriangles(positions, indices, tris);
+
+    boxes.resize(nodes.size());
+    for (uint i = static_cast<uint>(nodes.size()); i-- > 0;)
+    {
+        auto const& n = nodes[i];
+        if (!n.isleaf())
+        {
+            boxes[i] = boxes[n.left];
+            boxes[i] += boxes[n.right];
+            continue;
+        }
+
+        boxes[i] = triboxes.get(n.first);
+        for (uint t = n.first + 1; t < n.first + n.count; ++t)
+            boxes[i] += triboxes.get(t);
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "stdx/stdx.h"
+#include "engine/simplemath.h"
+#include "geocore.h"
+
+#include <array>
+#include <vector>
+#include <utility>
+
+namespace geometry
+{
+    using stdx::uint;
+
+    // bounding volume hierarchy over the triangles of an indexed mesh
+    // the hierarchy only depends on the mesh topology, so it is built once and shared, each deformed copy of the mesh refits its own boxes
+    struct trianglebvh
+    {
+        // leaves have count > 0 and cover tris[first, first + count), internal nodes have their children at left and right
+        struct node
+        {
+            uint left = 0, right = 0;
+            uint first = 0, count = 0;
+
+            bool isleaf() const { return count > 0; }
+        };
+
+        // triangles per leaf at most
+        static constexpr uint leafsize = 4;
+
+        // a balanced tree of leafsize leaves is nowhere near this deep
+        static constexpr uint maxdepth = 64;
+
+        trianglebvh() = default;
+        trianglebvh(std::vector<vertex> const& vertices, std::vector<uint> const& indices);
+
+        // triboxes[i] bounds the triangle at tris[i] and boxes[i] node i, a leaf's triangle boxes are contiguous
+        // children come after their parent so one pass from the back refits the whole tree
+        void refit(std::vector<vector3> const& positions, std::vector<uint> const& indices, aabbsoa& triboxes, std::vector<aabb>& boxes) const;
+
+        // nodes[0] is the root
+        std::vector<node> nodes;
+
+        // offsets of the first index of each triangle, in leaf order
+        std::vector<uint> tris;
+    };
+
+    // descends two refitted hierarchies together, visit(lleaf, rleaf) gets the pairs of leaves whose boxes overlap
+    template<typename visitor_t>
+    void descend(trianglebvh const& l, std::vector<aabb> const& lboxes, trianglebvh const& r, std::vector<aabb> const& rboxes, visitor_t&& visit)
+    {
+        if (l.nodes.empty() || r.nodes.empty())
+            return;
+
+        // the one with the bigger box is split, so both sides shrink at a similar rate
+        auto const extent = [](aabb const& b) { auto const d = b.span(); return d.x + d.y + d.z; };
+
+        std::array<std::pair<uint, uint>, 2 * trianglebvh::maxdepth> stack;
+        uint top = 0;
+        stack[top++] = { 0, 0 };
+        while (top > 0)
+        {
+            auto const [lidx, ridx] = stack[--top];
+            if (!lboxes[lidx].overlap(rboxes[ridx]))
+                continue;
+
+            auto const& ln = l.nodes[lidx];
+            auto const& rn = r.nodes[ridx];
+            if (ln.isleaf() && rn.isleaf())
+            {
+                visit(ln, rn);
+                continue;
+            }
+
+            assert(top + 2 <= stack.size());
+            if (rn.isleaf() || (!ln.isleaf() && extent(lboxes[lidx]) >= extent(rboxes[ridx])))
+            {
+                stack[top++] = { ln.left, ridx };
+                stack[top++] = { ln.right, ridx };
+            }
+            else
+            {
+                stack[top++] = { lidx, rn.left };
+                stack[top++] = { lidx, rn.right };
+            }
+        }
+    }
+}
@@ -0,0 +1,142 @@
+#include "distancefield.h"
+
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <algorithm>
+
+using namespace geometry;
+
+namespace
+{
+    using stdx::uint;
+
+    float boxdistance(aabb const& box, vector3 const& p)
+    {
+        auto const q = vector3{ std::fabs(p.x - box.center().x), std::fabs(p.y - box.center().y), std::fabs(p.z - box.center().z) } - box.span() / 2.f;
+        auto const outside = vector3::Max(q, vector3::Zero).Length();
+        auto const inside = std::min(std::max({ q.x, q.y, q.z }), 0.f);
+        return outside + inside;
+    }
+
+    // closest point on triangle abc to p, from real-time collision detection(ericson)
+    vector3 closestpoint(vector3 const& p, vector3 const& a, vector3 const& b, vector3 const& c)
+    {
+        auto const ab = b - a, ac = c - a, ap = p - a;
+        float const d1 = ab.Dot(ap), d2 = ac.Dot(ap);
+        if (d1 <= 0.f && d2 <= 0.f) return a;
+
+        auto const bp = p - b;
+        float const d3 = ab.Dot(bp), d4 = ac.Dot(bp);
+        if (d3 >= 0.f && d4 <= d3) return b;
+
+        float const vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) return a + ab * (d1 / (d1 - d3));
+
+        auto const cp = p - c;
+        float const d5 = ab.Dot(cp), d6 = ac.Dot(cp);
+        if (d6 >= 0.f && d5 <= d6) return c;
+
+        float const vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) return a + ac * (d2 / (d2 - d6));
+
+        float const va = d3 * d6 - d5 * d4;
+        if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        float const denom = 1.f / (va + vb + vc);
+        return a + ab * (vb * denom) + ac * (vc * denom);
+    }
+
+    // solid angle of triangle abc seen from p, signed by the winding(van oosterom and strackee)
+    float solidangle(vector3 const& p, vector3 const& a, vector3 const& b, vector3 const& c)
+    {
+        auto const ra = a - p, rb = b - p, rc = c - p;
+        float const la = ra.Length(), lb = rb.Length(), lc = rc.Length();
+        float const numerator = ra.Dot(rb.Cross(rc));
+        float const denominator = la * lb * lc + ra.Dot(rb) * lc + ra.Dot(rc) * lb + rb.Dot(rc) * la;
+        return 2.f * std::atan2(numerator, denominator);
+    }
+}
+
+geometry::distancefield::distancefield(aabb const& bounds, float cellsize) : box(bounds), cell(cellsize)
+{
+    auto const span = bounds.span();
+    auto const numnodes = [this](float len) { return static_cast<uint>(std::max(1.f, std::ceil(len / cell))) + 1; };
+    dims = { numnodes(span.x), numnodes(span.y), numnodes(span.z) };
+    values.assign(dims[0] * dims[1] * dims[2], std::numeric_limits<float>::max());
+}
+
+void geometry::distancefield::add(std::function<float(vector3 const&)> const& sd)
+{
+    for (uint z = 0; z < dims[2]; ++z)
+        for (uint y = 0; y < dims[1]; ++y)
+            for (uint x = 0; x < dims[0]; ++x)
+            {
+                auto& v = values[index(x, y, z)];
+                v = std::min(v, sd(box.min_pt + vector3{ float(x), float(y), float(z) } * cell));
+            }
+}
+
+void geometry::distancefield::addbox(aabb const& solid) { add([&solid](vector3 const& p) { return boxdistance(solid, p); }); }
+
+void geometry::distancefield::addroom(aabb const& room) { add([&room](vector3 const& p) { return -boxdistance(room, p); }); }
+
+void geometry::distancefield::addmesh(std::vector<vector3> const& positions, std::vector<uint> const& indices)
+{
+    if (indices.size() < 3)
+        return;
+
+    add([&](vector3 const& p)
+    {
+        float distsq = std::numeric_limits<float>::max();
+        float winding = 0.f;
+        for (uint i = 0; i + 2 < indices.size(); i += 3)
+        {
+            auto const& a = positions[indices[i]], &b = positions[indices[i + 1]], &c = positions[indices[i + 2]];
+            distsq = std::min(distsq, vector3::DistanceSquared(p, closestpoint(p, a, b, c)));
+            winding += solidangle(p, a, b, c);
+        }
+
+        // the winding number is about +-1 inside and 0 outside
+        float const dist = std::sqrt(distsq);
+        return std::fabs(winding) > 2.f * std::numbers::pi_v<float> ? -dist : dist;
+    });
+}
+
+float geometry::distancefield::distance(vector3 const& p) const { return query(p).distance; }
+
+geometry::distancefield::sample geometry::distancefield::query(vector3 const& p) const
+{
+    if (values.empty())
+        return { std::numeric_limits<float>::max(), vector3::UnitY };
+
+    // cell of p and where p is in it
+    auto const local = (vector3::Min(vector3::Max(p, box.min_pt), box.max_pt) - box.min_pt) / cell;
+    float const coords[3] = { local.x, local.y, local.z };
+    uint c[3];
+    float t[3];
+    for (uint i = 0; i < 3; ++i)
+    {
+        c[i] = std::min(static_cast<uint>(coords[i]), dims[i] - 2);
+        t[i] = coords[i] - float(c[i]);
+    }
+
+    float const v000 = values[index(c[0], c[1], c[2])], v100 = values[index(c[0] + 1, c[1], c[2])];
+    float const v010 = values[index(c[0], c[1] + 1, c[2])], v110 = values[index(c[0] + 1, c[1] + 1, c[2])];
+    float const v001 = values[index(c[0], c[1], c[2] + 1)], v101 = values[index(c[0] + 1, c[1], c[2] + 1)];
+    float const v011 = values[index(c[0], c[1] + 1, c[2] + 1)], v111 = values[index(c[0] + 1, c[1] + 1, c[2] + 1)];
+
+    auto const lerp = [](float a, float b, float t) { return a + (b - a) * t; };
+
+    // interpolate along x, then y, then z, the gradient is the derivative of the same interpolation
+    float const x00 = lerp(v000, v100, t[0]), x10 = lerp(v010, v110, t[0]), x01 = lerp(v001, v101, t[0]), x11 = lerp(v011, v111, t[0]);
+    float const y0 = lerp(x00, x10, t[1]), y1 = lerp(x01, x11, t[1]);
+
+    float const dx = lerp(lerp(v100 - v000, v110 - v010, t[1]), lerp(v101 - v001, v111 - v011, t[1]), t[2]);
+    float const dy = lerp(x10 - x00, x11 - x01, t[2]);
+    float const dz = y1 - y0;
+
+    auto const gradient = vector3{ dx, dy, dz };
+    float const len = gradient.Length();
+    return { lerp(y0, y1, t[2]), len > 0.f ? gradient / len : vector3::UnitY };
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "stdx/stdx.h"
+#include "stdx/vec.h"
+#include "engine/simplemath.h"
+#include "geocore.h"
+
+#include <vector>
+#include <functional>
+
+namespace geometry
+{
+    using stdx::uint;
+
+    // signed distances to static geometry sampled on a uniform grid, built once and then read with trilinear lookups
+    // distances are negative inside solids, solids added one after the other are merged by keeping the smaller distance
+    class distancefield
+    {
+    public:
+        struct sample
+        {
+            float distance;
+
+            // normalized gradient, points out of the closest solid
+            vector3 normal;
+        };
+
+        distancefield() = default;
+
+        // nodes cellsize apart cover bounds, they start out far from any solid
+        distancefield(aabb const& bounds, float cellsize);
+
+        void addbox(aabb const& box);
+
+        // the space outside room is solid, e.g. the walls of a level
+        void addroom(aabb const& room);
+
+        // a closed triangle mesh, inside and outside are told apart by the winding number so either winding order works
+        // every node is tested against every triangle, which is fine for a field built once at load
+        void addmesh(std::vector<vector3> const& positions, std::vector<uint> const& indices);
+
+        // points outside the bounds are clamped to them
+        float distance(vector3 const& p) const;
+        sample query(vector3 const& p) const;
+
+        aabb const& bounds() const { return box; }
+        float cellsize() const { return cell; }
+        uint memory() const { return static_cast<uint>(values.size() * sizeof(float)); }
+
+    private:
+        // merges the signed distance sd(node position) into every node
+        void add(std::function<float(vector3 const&)> const& sd);
+
+        uint index(uint x, uint y, uint z) const { return x + (y + z * dims[1]) * dims[0]; }
+
+        aabb box;
+        float cell = 1.f;
+        stdx::vecui3 dims = {};
+        std::vector<float> values;
+    };
+}
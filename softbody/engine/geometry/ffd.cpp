@@ -1,7 +1,9 @@
 #include "ffd.h"
 #include "geoutils.h"
-#include "engine/graphics/globalresources.h"
+#include "tritri.h"
+#include "aabbkernels.h"
 
+#include <bit>
 #include <ranges>
 #include <vector>
 #include <algorithm>
@@ -12,121 +14,239 @@ import primitives;
 using namespace geometry;
 using namespace DirectX;
 
-geometry::ffd_object::ffd_object(ffddata data) : _center(data.center)
+namespace
 {
-    _evaluated_verts = std::move(data.vertices);
-    auto const num_verts = _evaluated_verts.size();
+    using stdx::uint;
 
-    _vertices.reserve(num_verts);
-    _physx_verts.reserve(num_verts);
+    float thinnest(aabb const& box)
+    {
+        auto const span = box.span();
+        return std::min({ span.x, span.y, span.z });
+    }
+}
 
-    for (auto const& vert : _evaluated_verts)
-        _box += vert.position;
+geometry::ffdmesh::ffdmesh(indexedmesh const& mesh, beziermaths::weightstorage storage) : restvertices(mesh.vertices), indices(mesh.indices)
+{
+    aabb box;
+    for (auto const& vert : restvertices)
+        box += vert.position;
 
     // correct the geometric center
-    const auto boxcenter = _box.center();
-    _center += boxcenter;
-    for (auto i : std::ranges::iota_view(0u, _evaluated_verts.size()))
-    {
-        _evaluated_verts[i].position -= boxcenter;
-        _physx_verts.emplace_back(_evaluated_verts[i].position + _center);
-    }
+    offset = box.center();
+    restbox = box.move(-offset);
+    for (auto& vert : restvertices)
+        vert.position -= offset;
+
+    auto const& span = restbox.span();
+    restsize = span.Length();
+
+    std::vector<vertex> parametricverts;
+    parametricverts.reserve(restvertices.size());
+    for (auto const& vert : restvertices)
+        parametricverts.push_back({ ffd_object::parametric_coordinates(vert.position, span), vert.normal });
 
-    auto const& span = _box.span();
-    for (auto const& vert : _evaluated_verts)
-        _vertices.push_back({ parametric_coordinates(vert.position, span), vert.normal });
+    bvh = trianglebvh(restvertices, indices);
+    parametric = beziermaths::vertexsoa(parametricverts);
+    if (storage != beziermaths::weightstorage::none)
+        weights = beziermaths::weightcache(parametric, storage);
 
-    for (uint idx = 0; idx < _volume.numcontrolpts; ++idx)
+    for (uint idx = 0; idx < restconfig.size(); ++idx)
     {
         // calculate in range [-span/2, span/2]
         using cubeidx = stdx::grididx<2>;
         static constexpr float subtt = dim * 0.5f;
         auto const idx3d = cubeidx::from1d(dim, idx);
-        _rest_config[idx] = vector3{ span.x * (idx3d[0] - subtt), span.y * (idx3d[2] - subtt), span.z * (idx3d[1] - subtt) } / static_cast<float>(dim);
-        _volume.controlnet[idx] = _rest_config[idx];
+        restconfig[idx] = vector3{ span.x * (idx3d[0] - subtt), span.y * (idx3d[2] - subtt), span.z * (idx3d[1] - subtt) } / static_cast<float>(dim);
     }
-
-    _restsize = span.Length();
 }
 
-std::vector<linesegment> intersect(ffd_object const& l, ffd_object const& r)
+geometry::ffdmesh::ffdmesh(std::vector<vertex> const& triangles, beziermaths::weightstorage storage) : ffdmesh(geoutils::weld(triangles), storage) {}
+
+stdx::uint geometry::ffdmesh::memory() const
 {
-    auto const& isect_box = l.bboxworld().intersect(r.bboxworld());
-    if (!isect_box)
-        return {};
+    uint const soa = (parametric.x.size() + parametric.y.size() + parametric.z.size() + parametric.nx.size() + parametric.ny.size() + parametric.nz.size()) * sizeof(float);
+    uint const hierarchy = bvh.nodes.size() * sizeof(trianglebvh::node) + bvh.tris.size() * sizeof(uint);
+    return sizeof(ffdmesh) + restvertices.size() * sizeof(vertex) + indices.size() * sizeof(uint) + soa + hierarchy + weights.memory();
+}
 
-    auto const& ltris = l.physx_triangles();
-    auto const& rtris = r.physx_triangles();
+ffd_object geometry::ffd_world::add(ffddata data)
+{
+    uint const i = size();
+    auto const& mesh = *data.mesh;
+
+    // only the outputs are copied, they start out as the undeformed mesh
+    centers.push_back(data.center + mesh.offset);
+    previouscenters.push_back(centers.back());
+    velocities.push_back(vector3::Zero);
+    steplimits.push_back(std::numeric_limits<float>::max());
+    static physx::spring const defaultspring{};
+    springs.push_back({ defaultspring.springconst, defaultspring.eta });
+    maxdisplacements.push_back(mesh.restsize * 0.96f / 2.f);
+    boxes.push_back(mesh.restbox);
+    controlpoints.insert(controlpoints.end(), mesh.restconfig.begin(), mesh.restconfig.end());
+    restpoints.insert(restpoints.end(), mesh.restconfig.begin(), mesh.restconfig.end());
+    ctrlvelocities.resize(ctrlvelocities.size() + numcontrolpts, vector3::Zero);
+
+    auto& out = deformed.emplace_back();
+    out.vertices = mesh.restvertices;
+    out.positions.reserve(out.vertices.size());
+    for (auto const& vert : out.vertices)
+        out.positions.emplace_back(vert.position + centers[i]);
+
+    mesh.bvh.refit(out.positions, mesh.indices, out.triboxes, out.bvhboxes);
+    meshes.push_back(std::move(data.mesh));
+    return body(i);
+}
 
-    std::vector<stdx::ext<aabb, uint>> laabbs, raabbs;
+void geometry::ffd_world::step(float dt) { step(dt, 0, size()); }
 
-    laabbs.reserve(10);
-    raabbs.reserve(10);
+void geometry::ffd_world::step(float dt, uint first, uint count)
+{
+    for (uint i = first; i < first + count; ++i)
+    {
+        auto& s = springs[i];
+        if (s.dt != dt)
+            s.transition = physx::spring{ s.damping, s.stiffness }.transition(dt), s.dt = dt;
+    }
 
-    auto const lnum_verts = ltris.size();
-    auto const rnum_verts = rtris.size();
+    // the control points of consecutive bodies are consecutive, so bodies with the same spring are one run of floats
+    auto const& kernel = physx::springkernels::active();
+    for (uint run = first; run < first + count;)
+    {
+        uint next = run + 1;
+        while (next < first + count && springs[next].transition == springs[run].transition)
+            ++next;
 
-    assert(lnum_verts % 3 == 0);
-    assert(rnum_verts % 3 == 0);
+        uint const start = run * numcontrolpts;
+        kernel.step(reinterpret_cast<float*>(controlpoints.data() + start), reinterpret_cast<float const*>(restpoints.data() + start), reinterpret_cast<float*>(ctrlvelocities.data() + start), (next - run) * numcontrolpts * 3, springs[run].transition);
+        run = next;
+    }
 
-    for (uint lidx = 0; lidx < lnum_verts; lidx += 3)
+    for (uint i = first * numcontrolpts; i < (first + count) * numcontrolpts; ++i)
     {
-        stdx::ext<aabb, uint> lbox{ {&ltris[lidx], 3}, lidx };
-        if (isect_box.value().intersect(*lbox)) { laabbs.emplace_back(lbox); }
+        auto const deltapos = controlpoints[i] - restpoints[i];
+        auto const maxdisplacement = maxdisplacements[i / numcontrolpts];
+        if (deltapos.LengthSquared() > maxdisplacement * maxdisplacement)
+            controlpoints[i] = restpoints[i] + deltapos * (maxdisplacement / deltapos.Length());
     }
 
-    for (uint ridx = 0; ridx < rnum_verts; ridx += 3)
+    // center is not the geometric center and is not affected by deformations
+    for (uint i = first; i < first + count; ++i)
     {
-        stdx::ext<aabb, uint> rbox{ {&rtris[ridx], 3}, ridx };
-        if (isect_box.value().intersect(*rbox)) { raabbs.emplace_back(rbox); }
+        previouscenters[i] = centers[i];
+        velocities[i] -= velocities[i] * drag * dt;
+        centers[i] += velocities[i] * std::min(dt, steplimits[i]);
+        steplimits[i] = std::numeric_limits<float>::max();
     }
 
-    std::vector<linesegment> result;
-    for (uint lidx = 0; lidx < laabbs.size(); lidx++)
-        for (uint ridx = 0; ridx < raabbs.size(); ridx++)
-            if (laabbs[lidx]->intersect(raabbs[ridx]))
-                if (auto const& isect = triangle::intersect(&(ltris[laabbs[lidx].ex()]), &rtris[raabbs[ridx].ex()]))
-                    result.push_back(isect.value());
+    for (uint i = first; i < first + count; ++i)
+        boxes.set(i, aabb{ controlpoints.data() + i * numcontrolpts, numcontrolpts });
+}
 
-    return result;
+void geometry::ffd_world::deform(uint i)
+{
+    beziermaths::beziervolume<ffdmesh::dim> volume;
+    std::ranges::copy(controlnet(i), volume.controlnet.begin());
+
+    auto const& mesh = *meshes[i];
+    auto& out = deformed[i];
+    beziermaths::bulkevaluate(volume, mesh.parametric, mesh.weights, out.vertices, out.positions, centers[i]);
+    mesh.bvh.refit(out.positions, mesh.indices, out.triboxes, out.bvhboxes);
 }
 
-void ffd_object::update(float dt)
+void geometry::ffd_world::update(float dt)
+{
+    step(dt);
+    for (uint i = 0; i < size(); ++i)
+        deform(i);
+}
+
+std::vector<linesegment> intersect(ffd_object const& l, ffd_object const& r)
 {
-    static const physx::spring spring{};
-    for (uint ctrlpt_idx = 0; ctrlpt_idx < _volume.numcontrolpts; ++ctrlpt_idx)
+    using stdx::uint;
+
+    if (!l.bboxworld().overlap(r.bboxworld()))
+        return {};
+
+    auto const& lverts = l.physx_vertices();
+    auto const& rverts = r.physx_vertices();
+    auto const& lindices = l.indices();
+    auto const& rindices = r.indices();
+
+    // triangles are gathered through the index lists, first is the offset of the triangle's first index
+    auto const gather = [](std::vector<vector3> const& verts, std::vector<uint> const& indices, uint first, vector3 (&tri)[3])
     {
-        auto const displacement = _volume.controlnet[ctrlpt_idx] - _rest_config[ctrlpt_idx];
- 
-        auto const [deltapos_ctrlpt, newvel] = spring.damped(displacement, _velocities[ctrlpt_idx], dt);
-        auto const targetdir = deltapos_ctrlpt.Normalized();
-        
-        // clamp the displacement from equilibrium so that control points do not cross the center(some objects will escape boxes otherwise)
-        _volume.controlnet[ctrlpt_idx] = _rest_config[ctrlpt_idx] + std::min(deltapos_ctrlpt.Length(), _restsize * 0.96f / 2.f) * targetdir;
-
-        _velocities[ctrlpt_idx] = newvel;
-    }
+        tri[0] = verts[indices[first]], tri[1] = verts[indices[first + 1]], tri[2] = verts[indices[first + 2]];
+    };
+
+    // pairs whose triangle boxes overlap, each left triangle box is tested against the boxes of the right leaf at once
+    // pairs come out grouped by the left triangle so it is tested against batches of right ones
+    auto const& lbvh = l.mesh().bvh;
+    auto const& rbvh = r.mesh().bvh;
+    auto const& ltriboxes = l.triangleboxes();
+    auto const& rtriboxes = r.triangleboxes();
+    std::vector<std::pair<uint, uint>> candidatepairs;
+    vector3 ltri[3], rtri[3];
+    descend(lbvh, l.bvhboxes(), rbvh, r.bvhboxes(), [&](trianglebvh::node const& lleaf, trianglebvh::node const& rleaf)
+    {
+        static_assert(trianglebvh::leafsize <= aabbkernels::width, "hits holds one leaf");
+        uint hits[aabbkernels::width];
+        for (uint li = lleaf.first; li < lleaf.first + lleaf.count; ++li)
+        {
+            uint const numhits = rtriboxes.overlaps(ltriboxes.get(li), rleaf.first, rleaf.count, hits);
+            for (uint h = 0; h < numhits; ++h)
+                candidatepairs.emplace_back(lbvh.tris[li], rbvh.tris[hits[h]]);
+        }
+    });
 
-    _velocity += compute_wholebodyforces() * dt;
+    std::ranges::sort(candidatepairs);
 
-    // center is not the geometric center and is not affected by deformations
-    auto const delta_pos = _velocity * dt;
-    _center += delta_pos;
-    _box = aabb{ _volume.controlnet.data(), _volume.controlnet.size() };
+    // the kernel only rejects, the segments of the few pairs that overlap come from triangle::intersect
+    auto const& kernel = tritri::active();
+    std::vector<linesegment> result;
+    tritri::candidates batch;
+    uint batchtris[tritri::width];
+    auto const flush = [&]()
+    {
+        for (uint mask = kernel.overlaps(&ltri[0].x, batch); mask != 0; mask &= mask - 1)
+        {
+            gather(rverts, rindices, batchtris[std::countr_zero(mask)], rtri);
+            if (auto const& isect = triangle::intersect(ltri, rtri))
+                result.push_back(isect.value());
+        }
+
+        batch.count = 0;
+    };
+
+    for (std::size_t i = 0; i < candidatepairs.size(); ++i)
+    {
+        auto const [ltriidx, rtriidx] = candidatepairs[i];
+        if (batch.count == 0)
+            gather(lverts, lindices, ltriidx, ltri);
+
+        gather(rverts, rindices, rtriidx, rtri);
+        for (uint v = 0; v < 3; ++v)
+            batch.coords[v][0][batch.count] = rtri[v].x, batch.coords[v][1][batch.count] = rtri[v].y, batch.coords[v][2][batch.count] = rtri[v].z;
+
+        batchtris[batch.count++] = rtriidx;
+        if (batch.count == tritri::width || i + 1 == candidatepairs.size() || candidatepairs[i + 1].first != ltriidx)
+            flush();
+    }
 
-    _physx_verts.clear();
-    _evaluated_verts = beziermaths::bulkevaluate(_volume, _vertices);
+    return result;
+}
 
-    for (auto const& vtx : _evaluated_verts)
-        _physx_verts.emplace_back(vtx.position + _center);
+beziermaths::beziervolume<2> ffd_object::volume() const
+{
+    beziermaths::beziervolume<2> r;
+    std::ranges::copy(ctrlpts(), r.controlnet.begin());
+    return r;
 }
 
-std::vector<gfx::instance_data> ffd_object::controlnet_instancedata() const
+void ffd_object::update(float dt)
 {
-    std::vector<gfx::instance_data> instances_info;
-    instances_info.reserve(_volume.numcontrolpts);
-    for (auto const& ctrl_pt : _volume.controlnet) { instances_info.emplace_back(matrix::CreateTranslation(ctrl_pt + _center), gfx::globalresources::get().view(), gfx::globalresources::get().mat("")); }
-    return instances_info;
+    _world->step(dt, _index, 1);
+    _world->deform(_index);
 }
 
 vector3 ffd_object::eval_bez_trivariate(float s, float t, float u) const
@@ -141,15 +261,15 @@ vector3 ffd_object::eval_bez_trivariate(float s, float t, float u) const
     for (uint i = 0; i <= 2; ++i)
     {
         vector3 resultj = vector3::Zero;
-        float basis_s = (float(l) / float(fact(i) * fact(l - i))) * std::powf(float(1 - s), float(l - i)) * std::powf(s, float(i));
+        float basis_s = (float(l) / float(fact(i) * fact(l - i))) * std::pow(float(1 - s), float(l - i)) * std::pow(s, float(i));
         for (uint j = 0; j <= 2; ++j)
         {
             vector3 resultk = vector3::Zero;
-            float basis_t = (float(m) / float(fact(j) * fact(m - j))) * std::powf(float(1 - t), float(m - j)) * std::powf(t, float(j));
+            float basis_t = (float(m) / float(fact(j) * fact(m - j))) * std::pow(float(1 - t), float(m - j)) * std::pow(t, float(j));
             for (uint k = 0; k <= 2; ++k)
             {
-                float basis_u = (float(n) / float(fact(k) * fact(n - k))) * std::powf(float(1 - u), float(n - k)) * std::powf(u, float(k));
-                resultk += basis_u * _volume.controlnet[to1d(i, j, k)];
+                float basis_u = (float(n) / float(fact(k) * fact(n - k))) * std::pow(float(1 - u), float(n - k)) * std::pow(u, float(k));
+                resultk += basis_u * ctrlpts()[to1d(i, j, k)];
             }
 
             resultj += resultk * basis_t;
@@ -169,50 +289,95 @@ vector3 ffd_object::parametric_coordinates(vector3 const& cartesian_coordinates,
     return { to_point.x / span.x, to_point.y / span.y, to_point.z / span.z };
 }
 
-std::vector<vector3> geometry::ffd_object::controlpoint_visualization() const { return geoutils::create_cube_lines(vector3::Zero, 0.1f); }
-
-void ffd_object::move(vector3 delta)
+std::vector<vertex> ffd_object::vertices() const
 {
-    _center += delta;
-    _box.min_pt += delta;
-    _box.max_pt += delta;
+    std::vector<vertex> triangles;
+    triangles.reserve(mesh().indices.size());
+    for (auto const idx : mesh().indices)
+        triangles.push_back(uniquevertices()[idx]);
+
+    return triangles;
 }
 
+std::vector<vector3> geometry::ffd_object::controlpoint_visualization() const { return geoutils::create_cube_lines(vector3::Zero, 0.1f); }
+
+void ffd_object::move(vector3 delta) { pos() += delta; }
+
 vector3 ffd_object::compute_wholebodyforces() const
 {
-    auto const drag = -_velocity * 0.001f;
+    auto const drag = -velocity() * ffd_world::drag;
     return drag;
 }
 
-void ffd_object::resolve_collision(ffd_object & r, float dt)
+void ffd_object::resolve_collision(ffd_object& r, float dt)
 {
-    auto const contacts = compute_contacts(r);
-    if (contacts.size() <= 0)
-        return;
-    
-    std::vector<std::pair<uint, uint>> affected_ctrlpts;
-    for (uint i = 0; i < contacts.size(); ++i)
+    contactmanifold manifold;
+    resolve_collision(r, dt, manifold);
+}
+
+void ffd_object::resolve_collision(ffd_object& r, float dt, contactmanifold& manifold)
+{
+    // the narrowphase is skipped while neither the offset between the bodies nor their boxes(which follow the deformation) changed since it ran
+    manifold.reused = manifold.valid && geoutils::nearlyequal(r.center() - center(), manifold.offset, contact_reuse_distance)
+        && geoutils::nearlyequal(bbox().span(), manifold.lspan, contact_reuse_distance) && geoutils::nearlyequal(r.bbox().span(), manifold.rspan, contact_reuse_distance);
+
+    // the hull query of this frame, the separation expands it instead of solving again
+    gjk::separation hulls;
+    if (!manifold.reused)
     {
-        uint const li = closest_controlpoint(contacts[i]);
-        uint const ri = r.closest_controlpoint(contacts[i]);
-        affected_ctrlpts.push_back({ li, ri });
+        manifold.valid = true;
+        manifold.offset = r.center() - center();
+        manifold.lspan = bbox().span();
+        manifold.rspan = r.bbox().span();
+        manifold.contacts.clear();
+        manifold.ctrlpts.clear();
+
+        // pairs whose control net hulls are apart cannot touch, their triangles are never looked at
+        hulls = gjk::distance(controlhull(), r.controlhull(), manifold.axis);
+        if (!hulls.overlap)
+            manifold.axis = hulls.rpoint - hulls.lpoint;
+
+        for (auto const& contact : hulls.overlap ? compute_contacts(r) : std::vector<vector3>{})
+        {
+            manifold.contacts.push_back(contact - center());
+            manifold.ctrlpts.push_back({ closest_controlpoint(contact), r.closest_controlpoint(contact) });
+        }
     }
 
-    static constexpr float body_mass = 1.f;
-    static constexpr float ctrlpt_mass = body_mass / _volume.numcontrolpts;
+    auto const& affected_ctrlpts = manifold.ctrlpts;
+    if (affected_ctrlpts.empty())
+    {
+        manifold.impulse = 0.f;
+        return;
+    }
 
-    auto const normal = (_center - r._center).Normalized();
-    auto const relativevel = _velocity - r._velocity;
+    static constexpr float body_mass = 1.f;
+    static constexpr float ctrlpt_mass = body_mass / ffd_world::numcontrolpts;
 
+    auto const normal = (center() - r.center()).Normalized();
     static auto constexpr elasticity = 1.f;
-    auto const impulse = relativevel.Dot(normal) * elasticity * normal;
 
-    _velocity -= impulse;
-    r._velocity += impulse;
+    // apply last frame's impulse, then correct it, the accumulated impulse only ever pushes the bodies apart
+    // so a pair that is already separating gets nothing, where it used to be pulled back together
+    float const warm = manifold.impulse;
+    vel() += warm * normal;
+    r.vel() -= warm * normal;
 
-    // move a bit so they no longer collide, ideally should use mtd
-    move(normal * 0.1f);
-    r.move(-normal * 0.1f);
+    float const correction = -(velocity() - r.velocity()).Dot(normal) * elasticity;
+    manifold.impulse = std::max(warm + correction, 0.f);
+    vel() += (manifold.impulse - warm) * normal;
+    r.vel() -= (manifold.impulse - warm) * normal;
+
+    auto const impulse = -manifold.impulse * normal;
+
+    // each moves half the translation that separates them, so the next frame does not collide them again
+    auto const mtd = separation(r, manifold, hulls);
+    move(mtd / 2.f);
+    r.move(-mtd / 2.f);
+
+    // compared against where new contacts left the pair, reused ones keep that offset so the reuse cannot drift
+    if (!manifold.reused)
+        manifold.offset = r.center() - center();
 
     auto const ctrl_impulsemultiplier = 3.f;
     auto const impulse_per_ctrlpt = impulse * ctrl_impulsemultiplier / static_cast<float>(affected_ctrlpts.size());
@@ -220,85 +385,164 @@ void ffd_object::resolve_collision(ffd_object & r, float dt)
     {
         auto const [idx, idx_other] = affected_ctrlpts[i];
 
-        auto const relativev = _velocities[idx] - r._velocities[idx_other];
-        auto const impulse_ctrlpts = relativev.Dot(normal) * normal * (1.f + elasticity)/ static_cast<float>(_volume.numcontrolpts);
+        auto const relativev = ctrlvels()[idx] - r.ctrlvels()[idx_other];
+        auto const impulse_ctrlpts = relativev.Dot(normal) * normal * (1.f + elasticity)/ static_cast<float>(ffd_world::numcontrolpts);
 
-        _velocities[idx] -= (impulse_per_ctrlpt + impulse_ctrlpts);
-        r._velocities[idx_other] += (impulse_per_ctrlpt + impulse_ctrlpts);
+        ctrlvels()[idx] -= (impulse_per_ctrlpt + impulse_ctrlpts);
+        r.ctrlvels()[idx_other] += (impulse_per_ctrlpt + impulse_ctrlpts);
     }
 }
 
-void ffd_object::resolve_collision_interior(aabb const& r, float dt)
+vector3 ffd_object::separation(ffd_object const& r, contactmanifold& manifold, gjk::separation const& hulls) const
 {
-    // this checks only box-box intersection
-    auto const& isect_box = bboxworld().intersect(r);
-    if (!isect_box)
+    // the hulls give the direction they overlap least along, they are looser than the mesh so their own depth would overshoot
+    // reused contacts keep the direction of the frame that found them, the bodies have not moved apart since
+    // the line between the centers is the other candidate, it is the best one for round bodies whose hulls are boxy
+    auto const centerdir = (center() - r.center()).Normalized();
+    auto const hullmtd = manifold.reused ? -manifold.axis : gjk::penetration(controlhull(), r.controlhull(), hulls);
+    auto const hulldir = hullmtd == vector3::Zero ? centerdir : hullmtd.Normalized();
+    if (!manifold.reused && hullmtd != vector3::Zero)
+        manifold.axis = -hulldir;
+
+    // the overlap of the deformed vertices projected on both directions in one pass, moving this body that far along one separates them
+    float lmin[2] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    float rmax[2] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+    for (auto const& v : physx_vertices())
+        lmin[0] = std::min(lmin[0], v.Dot(hulldir)), lmin[1] = std::min(lmin[1], v.Dot(centerdir));
+    for (auto const& v : r.physx_vertices())
+        rmax[0] = std::max(rmax[0], v.Dot(hulldir)), rmax[1] = std::max(rmax[1], v.Dot(centerdir));
+
+    float const hulldepth = std::max(rmax[0] - lmin[0], 0.f), centerdepth = std::max(rmax[1] - lmin[1], 0.f);
+    return hulldepth < centerdepth ? hulldir * hulldepth : centerdir * centerdepth;
+}
+
+void ffd_object::resolve_collision(distancefield const& field, float dt)
+{
+    // the field is about a distance, so a body whose box cannot reach a solid is skipped after one lookup
+    float const reach = bbox().span().Length() / 2.f + field.cellsize();
+    if (field.distance(center()) > reach)
         return;
 
-    std::vector<vector3> contacts;
+    // the normals of the penetrating vertices weighted by their depth give the direction to push the body
+    vector3 normal = vector3::Zero;
+    float depth = 0.f;
+    std::array<bool, ffd_world::numcontrolpts> affected = {};
+    for (auto const& vert : physx_vertices())
+    {
+        auto const sample = field.query(vert);
+        if (sample.distance >= 0.f)
+            continue;
 
-    if (isect_box->max_pt.x >= (r.max_pt.x - stdx::tolerance<>))
-        contacts.emplace_back(isect_box->max_pt.x, _center.y, _center.z);
+        normal -= sample.normal * sample.distance;
+        depth = std::max(depth, -sample.distance);
+        affected[closest_controlpoint(vert)] = true;
+    }
 
-    if (isect_box->min_pt.x <= (r.min_pt.x + stdx::tolerance<>))
-        contacts.emplace_back(isect_box->min_pt.x, _center.y, _center.z);
+    if (depth <= 0.f)
+        return;
 
-    if (isect_box->max_pt.y >= (r.max_pt.y - stdx::tolerance<>))
-        contacts.emplace_back(_center.x, isect_box->max_pt.y, _center.z);
+    normal.Normalize();
 
-    if (isect_box->min_pt.y <= (r.min_pt.y + stdx::tolerance<>))
-        contacts.emplace_back(_center.x, isect_box->min_pt.y, _center.z);
+    static constexpr float body_mass = 1.f;
+    static constexpr float ctrlpt_mass = body_mass / ffd_world::numcontrolpts;
 
-    if (isect_box->max_pt.z >= (r.max_pt.z - stdx::tolerance<>))
-        contacts.emplace_back(_center.x, _center.y, isect_box->max_pt.z);
+    static auto constexpr elasticity = 1.f;
+    float const approach = std::max(-velocity().Dot(normal), 0.f);
+    auto const impulse_magnitude = approach * elasticity;
 
-    if (isect_box->min_pt.z <= (r.min_pt.z + stdx::tolerance<>))
-        contacts.emplace_back(_center.x, _center.y, isect_box->min_pt.z);
+    // reflect the part of the velocity going into the solid, a body already moving out keeps its velocity
+    vel() += (1.f + elasticity) * approach * normal;
 
-    if (contacts.size() <= 0) return;
+    // out of the solid by the deepest penetration
+    move(normal * depth);
 
-    vector3 normal = vector3::Zero;
-    std::vector<uint> affected_ctrlpts;
-    for (auto const& c : contacts)
+    uint const numaffected = static_cast<uint>(std::ranges::count(affected, true));
+    auto const impulse_per_ctrlpt = 2.f * impulse_magnitude / static_cast<float>(numaffected);
+
+    // push control points in
+    for (uint i = 0; i < affected.size(); ++i)
     {
-        normal += c;
-        affected_ctrlpts.push_back(closest_controlpoint(c));
+        if (!affected[i])
+            continue;
+
+        auto const deltavel_dir = (center() - ctrlpts()[i]).Normalized();
+        ctrlvels()[i] += impulse_per_ctrlpt * deltavel_dir;
     }
+}
 
-    // average the contacts to find the normal for computing new velocity
-    normal /= static_cast<float>(contacts.size());
-    normal = (_center - normal).Normalized();
+aabb ffd_object::sweptbox(float dt) const
+{
+    auto swept = bboxworld();
+    swept += bboxworld().move(velocity() * dt);
+    return swept;
+}
 
-    static constexpr float body_mass = 1.f;
-    static constexpr float ctrlpt_mass = body_mass / _volume.numcontrolpts;
+std::optional<float> ffd_object::timeofimpact(ffd_object const& r, float dt) const
+{
+    // the travel of l as seen from r
+    auto const relvelocity = velocity() - r.velocity();
+    float const speed = relvelocity.Length();
+    float const safetravel = ccd_travel * std::min(thinnest(mesh().restbox), thinnest(r.mesh().restbox));
+    if (speed * dt <= safetravel)
+        return {};
 
-    static auto constexpr elasticity = 1.f;
-    auto const impulse_magnitude = _velocity.Dot(-normal) * elasticity;
- 
-    // reflect along normal
-    _velocity = _velocity.Length() * normal;
+    float const safetime = safetravel / speed;
+    float t = 0.f;
+    for (uint iter = 0; iter < 32; ++iter)
+    {
+        auto const sep = gjk::distance({ ctrlpts(), center() + relvelocity * t }, { r.ctrlpts(), r.center() });
+        if (sep.overlap || sep.distance <= toi_distance)
+            return std::max(t, safetime);
+
+        // the hulls cannot meet before their gap closes at the speed they approach along the closest direction
+        float const approach = relvelocity.Dot((sep.rpoint - sep.lpoint) / sep.distance);
+        if (approach <= 0.f)
+            return {};
+
+        t += sep.distance / approach;
+        if (t >= dt)
+            return {};
+    }
+
+    return std::max(t, safetime);
+}
 
-    // move it away from wall, to avoid duplicate collisions, ideally should use mtd
-    move(normal * 0.1f);
+std::optional<float> ffd_object::timeofimpact(distancefield const& field, float dt) const
+{
+    float const speed = velocity().Length();
+    float const safetravel = ccd_travel * thinnest(mesh().restbox);
+    if (speed * dt <= safetravel)
+        return {};
 
-    auto const impulse_per_ctrlpt = 2.f * impulse_magnitude / static_cast<float>(affected_ctrlpts.size());
+    float radius = 0.f;
+    for (auto const& ctrlpt : ctrlpts())
+        radius = std::max(radius, ctrlpt.Length());
 
-    // push control points in
-    for (uint i = 0; i < affected_ctrlpts.size(); ++i)
+    // the field is no steeper than 1, so the sphere travels its distance to the solids without reaching them
+    float const safetime = safetravel / speed;
+    float t = 0.f;
+    for (uint iter = 0; iter < 32; ++iter)
     {
-        auto const deltavel_dir = (_center - _volume.controlnet[affected_ctrlpts[i]]).Normalized();
-        _velocities[affected_ctrlpts[i]] += impulse_per_ctrlpt * deltavel_dir;
+        float const gap = field.distance(center() + velocity() * t) - radius;
+        if (gap <= toi_distance)
+            return std::max(t, safetime);
+
+        t += gap / speed;
+        if (t >= dt)
+            return {};
     }
+
+    return std::max(t, safetime);
 }
 
-uint ffd_object::closest_controlpoint(vector3 point) const
+stdx::uint ffd_object::closest_controlpoint(vector3 point) const
 {
-    point -= _center;
+    point -= center();
     uint ctrlpt_idx = 0;
     float distsqr_min = std::numeric_limits<float>::max();
-    for (uint i = 0; i < _volume.numcontrolpts; ++i)
+    for (uint i = 0; i < ffd_world::numcontrolpts; ++i)
     {
-        if (auto const distsqr = vector3::DistanceSquared(point, _volume.controlnet[i]); distsqr < distsqr_min)
+        if (auto const distsqr = vector3::DistanceSquared(point, ctrlpts()[i]); distsqr < distsqr_min)
         {
             distsqr_min = distsqr;
             ctrlpt_idx = i;
@@ -308,40 +552,22 @@ uint ffd_object::closest_controlpoint(vector3 point) const
     return ctrlpt_idx;
 }
 
-std::vector<vector3> ffd_object::compute_contacts(ffd_object const& other) const
+std::vector<vector3> ffd_object::compute_contacts(ffd_object const& other, uint _maxcontacts) const
 {
     auto const lines = intersect(*this, other);
 
     std::vector<vector3> mids;
-    mids.reserve(lines.size() / 2);
-    for (uint i = 0; i < lines.size(); i++) { mids.push_back((lines[i].v0 + lines[i].v1) / 2.f); }
-
-    auto constexpr contact_radius = 0.1f;
-    auto constexpr contact_radius_squared2 = 2 * contact_radius * contact_radius;
-    std::vector<vector3> contacts;
-
-    // naively cluster points around first point that is not in existing clusters
-    for (uint i = 0; i < mids.size(); ++i)
-    {
-        contacts.push_back(mids[i]);
-        for (uint j = i + 1; j < mids.size(); ++j)
-        {
-            if (vector3::DistanceSquared(mids[i], mids[j]) < contact_radius_squared2)
-            {
-                std::swap(mids[j], mids[mids.size() - 1]);
-                mids.pop_back();
-                j--;
-            }
-        }
-    }
+    mids.reserve(lines.size());
+    for (auto const& line : lines)
+        mids.push_back((line.v0 + line.v1) / 2.f);
 
-    return contacts;
+    return geoutils::clusterpoints(mids, contact_radius, _maxcontacts);
 }
 
 vector3 ffd_object::compute_contact(ffd_object const& r) const
 {
     // compute a simple single contact
-    auto const& isect_box = _box.intersect(r.bbox());
+    auto const& isect_box = bbox().intersect(r.bbox());
     if (!isect_box)
         return stdx::invalid<vector3>();
 
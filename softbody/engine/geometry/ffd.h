@@ -3,18 +3,26 @@
 #include "stdx/stdx.h"
 #include "engine/simplemath.h"
 #include "engine/engineutils.h"
-#include "engine/graphics/gfxcore.h"
+#include "engine/graphics/gfxfwd.h"
+#include "engine/physics/springkernels.h"
+#include "bvh.h"
 #include "geocore.h"
+#include "distancefield.h"
+#include "gjk.h"
 #include "beziermaths.h"
 
 #include <array>
+#include <memory>
+#include <limits>
+#include <span>
 #include <vector>
 #include <cstdint>
-
-import shapes;
+#include <optional>
 
 namespace geometry
 {
+    using stdx::uint;
+
     template <typename t>
     concept shapeffd_c = requires(t v)
     {
@@ -24,35 +32,227 @@ namespace geometry
         {v.triangles()} -> std::convertible_to<std::vector<vertex>>;
     };
 
+    // what bodies deformed from the same vertices have in common, immutable so any number of bodies can share one
+    struct ffdmesh
+    {
+        static constexpr uint dim = 2;
+
+        ffdmesh(indexedmesh const& mesh, beziermaths::weightstorage storage = beziermaths::weightstorage::none);
+
+        // welds a triangle list first, so deformation runs once per unique vertex
+        ffdmesh(std::vector<vertex> const& triangles, beziermaths::weightstorage storage = beziermaths::weightstorage::none);
+
+        uint memory() const;
+
+        // unique vertices moved so their bounds are centered at the origin, offset is what was subtracted
+        std::vector<vertex> restvertices;
+        std::vector<uint> indices;
+        trianglebvh bvh;
+        vector3 offset;
+        aabb restbox;
+        float restsize = 0.f;
+
+        beziermaths::vertexsoa parametric;
+        beziermaths::weightcache weights;
+        std::array<vector3, beziermaths::beziervolume<dim>::numcontrolpts> restconfig;
+    };
+
     struct ffddata
     {
         vector3 center;
-        std::vector<vertex> vertices;
+        std::shared_ptr<ffdmesh const> mesh;
+    };
+
+    ffddata createffddata(shapeffd_c auto shape, beziermaths::weightstorage storage = beziermaths::weightstorage::none)
+    {
+        auto const center = shape.gcenter();
+        shape.scenter(vector3::Zero);
+        shape.generate_triangles();
+        return { center, std::make_shared<ffdmesh const>(shape.triangles(), storage) };
+    }
+
+    // what resolving a pair of bodies keeps for the next frame, contacts and offsets are relative to the first body's center
+    struct contactmanifold
+    {
+        bool valid = false;
+
+        // the contacts were reused instead of recomputed by the last resolve
+        bool reused = false;
+
+        vector3 offset = {};
+        vector3 lspan = {}, rspan = {};
+        std::vector<vector3> contacts;
+        std::vector<std::pair<uint, uint>> ctrlpts;
+
+        // accumulated along the normal, applied first the next frame(warm start)
+        float impulse = 0.f;
+
+        // from the first body towards the second as last seen by the hull queries, where the next ones start looking
+        // reused contacts are separated against it instead of querying the hulls again
+        vector3 axis = {};
+    };
+
+    class ffd_object;
+
+    // the state of every body in contiguous arrays, ffd_objects are handles into it
+    // control points, their velocities and rest positions are numcontrolpts consecutive entries per body, so a step sweeps the control points of all bodies in one loop
+    class ffd_world
+    {
+    public:
+        static constexpr uint numcontrolpts = beziermaths::beziervolume<ffdmesh::dim>::numcontrolpts;
+
+        // drag on the velocity of the centers, per second
+        static constexpr float drag = 0.001f;
+
+        // the handle stays valid while the world lives, adding bodies moves the arrays but not the indices
+        ffd_object add(ffddata data);
+        ffd_object body(uint i);
+        uint size() const { return static_cast<uint>(centers.size()); }
+
+        // springs every control point back towards rest, then moves the centers and refits the boxes of every body
+        // the control points of consecutive bodies with the same spring go through the spring kernel together
+        void step(float dt);
+
+        // evaluates body i's mesh at its control points and refits its hierarchy, bodies do not share outputs so they can be deformed in parallel
+        void deform(uint i);
+
+        // step and deform every body
+        void update(float dt);
+
+        // where between the centers before and after the last step bodies are drawn, t in [0, 1]
+        void interpolate(float t) { drawtime = t; }
+
+    private:
+        friend class ffd_object;
+
+        // what deforming a body produces, buffers keep their size from add so steady state frames allocate nothing
+        struct deformation
+        {
+            std::vector<vertex> vertices;
+
+            // world positions of vertices
+            std::vector<vector3> positions;
+
+            // the mesh's bvh refitted to positions, triangle boxes in the order of the bvh's tris
+            std::vector<aabb> bvhboxes;
+            aabbsoa triboxes;
+        };
+
+        // a body's spring and its transition over the last dt it stepped with, only recomputed when dt or the spring changes
+        struct springstate
+        {
+            float stiffness;
+            float damping;
+            float dt = 0.f;
+            physx::springkernels::transition transition;
+        };
+
+        void step(float dt, uint first, uint count);
+
+        std::span<vector3, numcontrolpts> controlnet(uint i) { return std::span<vector3, numcontrolpts>(controlpoints.data() + i * numcontrolpts, numcontrolpts); }
+        std::span<vector3, numcontrolpts> controlvelocities(uint i) { return std::span<vector3, numcontrolpts>(ctrlvelocities.data() + i * numcontrolpts, numcontrolpts); }
+
+        // per body, everything bodies made from the same mesh have in common is in the mesh
+        std::vector<std::shared_ptr<ffdmesh const>> meshes;
+        std::vector<vector3> centers;
+
+        // centers at the start of the last step
+        std::vector<vector3> previouscenters;
+        float drawtime = 1.f;
+        std::vector<vector3> velocities;
+        std::vector<float> steplimits;
+        std::vector<springstate> springs;
+
+        // how far a control point may get from rest, so it does not cross the center(some objects will escape boxes otherwise)
+        std::vector<float> maxdisplacements;
+
+        // bounds of the control nets around the centers
+        aabbsoa boxes;
+
+        // per control point
+        std::vector<vector3> controlpoints;
+        std::vector<vector3> restpoints;
+        std::vector<vector3> ctrlvelocities;
+
+        std::vector<deformation> deformed;
     };
 
+    // a body of an ffd_world, cheap to copy, copies refer to the same body
     class ffd_object
     {
     public:
-        ffd_object(ffddata data);
-        
-        box box() const { return _box; }
-        aabb const& bbox() const { return _box; }
-        aabb bboxworld() const { return _box.move(_center); }
-        vector3 const& center() const { return _center; }
-        vector3 const& velocity() const { return _velocity; }
-        void svelocity(vector3 const& vel) { _velocity = vel; }
+        // intersection points closer than about contact_radius become one contact, at most maxcontacts are kept per pair of bodies
+        static constexpr float contact_radius = 0.1f;
+        static constexpr uint maxcontacts = 16;
+
+        // contacts of a pair are reused while neither the offset between the bodies nor their boxes changed by more than this
+        static constexpr float contact_reuse_distance = 0.01f;
+
+        // a body travelling less than this fraction of its thinnest side in a step cannot skip through anything, so it needs no time of impact
+        static constexpr float ccd_travel = 0.25f;
+
+        // conservative advancement stops when the hulls are this close
+        static constexpr float toi_distance = 0.01f;
+
+        geometry::box box() const { return bbox(); }
+        aabb bbox() const { return _world->boxes.get(_index); }
+        aabb bboxworld() const { return bbox().move(center()); }
+        vector3 const& center() const { return _world->centers[_index]; }
+
+        // the center to render at, between the last two steps as set by ffd_world::interpolate
+        vector3 drawcenter() const { return vector3::Lerp(_world->previouscenters[_index], center(), _world->drawtime); }
+        vector3 const& velocity() const { return _world->velocities[_index]; }
+        void svelocity(vector3 const& vel) { _world->velocities[_index] = vel; }
+
+        // stiffness is per unit mass, damping is the ratio to critical damping
+        void sspring(float stiffness, float damping) { _world->springs[_index] = { stiffness, damping }; }
         std::vector<vector3> boxvertices() const { return box().vertices(); }
-        std::vector<vertex> const& vertices() const { return _evaluated_verts; }
-        std::vector<vector3> const& physx_triangles() const { return _physx_verts; }
+        std::vector<vertex> const& uniquevertices() const { return _world->deformed[_index].vertices; }
+        std::vector<vector3> const& physx_vertices() const { return _world->deformed[_index].positions; }
+        std::vector<uint> const& indices() const { return mesh().indices; }
+        std::vector<aabb> const& bvhboxes() const { return _world->deformed[_index].bvhboxes; }
+        aabbsoa const& triangleboxes() const { return _world->deformed[_index].triboxes; }
+        ffdmesh const& mesh() const { return *_world->meshes[_index]; }
         std::vector<uint8_t> const& texturedata() const { static std::vector<uint8_t> r(4); return r; }
 
+        // a copy of the control net
+        beziermaths::beziervolume<2> volume() const;
+
+        // the deformed mesh is inside the convex hull of the control net
+        gjk::hull controlhull() const { return { _world->controlnet(_index), center() }; }
+
+        // triangle list gathered through the indices, for the renderer
+        std::vector<vertex> vertices() const;
+
         void move(vector3 delta);
+
+        // steps and deforms this body alone, ffd_world::update does all of them at once
         void update(float dt);
         vector3 compute_wholebodyforces() const;
         vector3 compute_contact(ffd_object const&) const;
-        std::vector<vector3> compute_contacts(ffd_object const&) const;
+        std::vector<vector3> compute_contacts(ffd_object const& r, uint _maxcontacts = maxcontacts) const;
         void resolve_collision(ffd_object& r, float dt);
-        void resolve_collision_interior(aabb const& r, float dt);
+
+        // same with the pair's state from the previous frame, which is updated
+        void resolve_collision(ffd_object& r, float dt, contactmanifold& manifold);
+
+        // collides the deformed vertices with static geometry, pushes the body out along the field's gradient by the deepest penetration
+        void resolve_collision(distancefield const& field, float dt);
+
+        // the world box grown by the travel over dt, pairs of these boxes are the bodies that may meet during the step
+        aabb sweptbox(float dt) const;
+
+        // how far into dt the pair can travel before the control net hulls(which hold the deformed mesh) meet, nothing when it can travel all of dt
+        // found by conservative advancement of the motion of the centers, the deformation during the step is ignored
+        // a pair always gets to travel ccd_travel of the thinner body, so bodies whose hulls already touch keep closing in until the discrete pass finds them
+        std::optional<float> timeofimpact(ffd_object const& r, float dt) const;
+
+        // the same against static geometry, a sphere around the control net is traced through the field
+        std::optional<float> timeofimpact(distancefield const& field, float dt) const;
+
+        // the next step moves the center for at most t seconds of its dt, the control points still spring back for the whole dt
+        void limitstep(float t) { _world->steplimits[_index] = std::min(_world->steplimits[_index], t); }
+
         uint closest_controlpoint(vector3 point) const;
         std::vector<vector3> controlpoint_visualization() const;
         std::vector<gfx::instance_data> controlnet_instancedata() const;
@@ -61,19 +261,23 @@ namespace geometry
         static vector3 parametric_coordinates(vector3 const& cartesian_coordinates, vector3 const& span);
 
     private:
+        friend class ffd_world;
 
-        aabb _box;
-        vector3 _center = {};
-        vector3 _velocity = {};
-        float _restsize = 0.f;
-        std::vector<vector3> _physx_verts;
-        std::vector<vertex> _evaluated_verts;
-        std::vector<vertex> _vertices;
+        ffd_object(ffd_world* world, uint index) : _world(world), _index(index) {}
 
-        static constexpr uint dim = 2;
-        beziermaths::beziervolume<dim> _volume;
+        // the translation of this body that separates it from r, hulls is the distance query of the frame's new contacts and is expanded to update manifold.axis
+        // reused contacts take the direction in manifold.axis instead of querying the hulls
+        vector3 separation(ffd_object const& r, contactmanifold& manifold, gjk::separation const& hulls) const;
 
-        std::array<vector3, beziermaths::beziervolume<dim>::numcontrolpts> _rest_config;
-        std::array<vector3, beziermaths::beziervolume<dim>::numcontrolpts> _velocities = {};
+        // this body's state in the world, writable through any copy of the handle
+        vector3& pos() const { return _world->centers[_index]; }
+        vector3& vel() const { return _world->velocities[_index]; }
+        std::span<vector3, ffd_world::numcontrolpts> ctrlpts() const { return _world->controlnet(_index); }
+        std::span<vector3, ffd_world::numcontrolpts> ctrlvels() const { return _world->controlvelocities(_index); }
+
+        ffd_world* _world = nullptr;
+        uint _index = 0;
     };
-}
\ No newline at end of file
+
+    inline ffd_object ffd_world::body(uint i) { return { this, i }; }
+}
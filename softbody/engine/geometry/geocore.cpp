@@ -1,5 +1,6 @@
 #include "geocore.h"
 #include "geoutils.h"
+#include "aabbkernels.h"
 
 #include<algorithm>
 
@@ -54,6 +55,19 @@ aabb& geometry::aabb::operator+=(vector3 const& pt)
     return *this;
 }
 
+aabb& geometry::aabb::operator+=(aabb const& r)
+{
+    min_pt.x = std::min(r.min_pt.x, min_pt.x);
+    min_pt.y = std::min(r.min_pt.y, min_pt.y);
+    min_pt.z = std::min(r.min_pt.z, min_pt.z);
+
+    max_pt.x = std::max(r.max_pt.x, max_pt.x);
+    max_pt.y = std::max(r.max_pt.y, max_pt.y);
+    max_pt.z = std::max(r.max_pt.z, max_pt.z);
+
+    return *this;
+}
+
 std::optional<aabb> geometry::aabb::intersect(aabb const& r) const
 {
     if (max_pt.x < r.min_pt.x || min_pt.x > r.max_pt.x) return {};
@@ -65,3 +79,56 @@ std::optional<aabb> geometry::aabb::intersect(aabb const& r) const
 
     return { {min, max} };
 }
+
+geometry::aabbsoa::aabbsoa(std::vector<aabb> const& boxes)
+{
+    resize(static_cast<uint>(boxes.size()));
+    for (uint i = 0; i < count; ++i)
+        set(i, boxes[i]);
+}
+
+void geometry::aabbsoa::resize(uint n)
+{
+    count = n;
+    minx.resize(n), miny.resize(n), minz.resize(n);
+    maxx.resize(n), maxy.resize(n), maxz.resize(n);
+}
+
+void geometry::aabbsoa::set(uint i, aabb const& box)
+{
+    minx[i] = box.min_pt.x, miny[i] = box.min_pt.y, minz[i] = box.min_pt.z;
+    maxx[i] = box.max_pt.x, maxy[i] = box.max_pt.y, maxz[i] = box.max_pt.z;
+}
+
+void geometry::aabbsoa::push_back(aabb const& box)
+{
+    resize(count + 1);
+    set(count - 1, box);
+}
+
+void geometry::aabbsoa::removeswap(uint i)
+{
+    set(i, get(count - 1));
+    resize(count - 1);
+}
+
+void geometry::aabbsoa::fromtriangles(std::vector<vector3> const& positions, std::vector<uint> const& indices, std::vector<uint> const& tris)
+{
+    resize(static_cast<uint>(tris.size()));
+    aabbkernels::boxoutput const out{ { minx.data(), miny.data(), minz.data() }, { maxx.data(), maxy.data(), maxz.data() } };
+    aabbkernels::active().fromtriangles(reinterpret_cast<float const*>(positions.data()), indices.data(), tris.data(), count, out);
+}
+
+stdx::uint geometry::aabbsoa::overlaps(aabb const& box, uint first, uint num, uint* out) const
+{
+    assert(first + num <= count);
+    float const b[6] = { box.min_pt.x, box.min_pt.y, box.min_pt.z, box.max_pt.x, box.max_pt.y, box.max_pt.z };
+    aabbkernels::boxrange const range{ { minx.data(), miny.data(), minz.data() }, { maxx.data(), maxy.data(), maxz.data() }, first, num };
+    return aabbkernels::active().overlaps(b, range, out);
+}
+
+void geometry::aabbsoa::overlaps(aabb const& box, std::vector<uint>& out) const
+{
+    out.resize((count + aabbkernels::width - 1) / aabbkernels::width * aabbkernels::width);
+    out.resize(overlaps(box, 0, count, out.data()));
+}
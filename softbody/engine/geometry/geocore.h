@@ -9,6 +9,8 @@
 
 namespace geometry
 {
+    using stdx::uint;
+
     struct nullshape {};
 
     struct vertex
@@ -21,6 +23,13 @@ namespace geometry
         constexpr vertex(vector3 const& pos, vector3 const& norm, vector2 txcoord = {}) : position(pos), normal(norm), texcoord(txcoord) {}
     };
 
+    // unique vertices and a triangle list of indices into them
+    struct indexedmesh
+    {
+        std::vector<vertex> vertices;
+        std::vector<uint> indices;
+    };
+
     struct box
     {
         box() = default;
@@ -45,10 +54,45 @@ namespace geometry
         aabb move(vector3 const& off) const { return aabb(min_pt + off, max_pt + off); }
 
         aabb& operator+=(vector3 const& pt);
+        aabb& operator+=(aabb const& r);
         std::optional<aabb> intersect(aabb const& r) const;
 
+        // touching boxes overlap
+        bool overlap(aabb const& r) const { return min_pt.x <= r.max_pt.x && r.min_pt.x <= max_pt.x && min_pt.y <= r.max_pt.y && r.min_pt.y <= max_pt.y && min_pt.z <= r.max_pt.z && r.min_pt.z <= max_pt.z; }
+
         // top left front = min, bot right back = max
         vector3 min_pt;
         vector3 max_pt;
     };
+
+    // boxes as structure of arrays, one box is tested against a range of them a simd register at a time
+    // the kernels are picked at runtime for the cpu, see simd::active
+    struct aabbsoa
+    {
+        aabbsoa() = default;
+        aabbsoa(std::vector<aabb> const& boxes);
+
+        uint size() const { return count; }
+        void resize(uint n);
+
+        aabb get(uint i) const { return { { minx[i], miny[i], minz[i] }, { maxx[i], maxy[i], maxz[i] } }; }
+        void set(uint i, aabb const& box);
+        void push_back(aabb const& box);
+
+        // moves the last box to i, so the order of the boxes is not kept
+        void removeswap(uint i);
+
+        // box i bounds the triangle whose first index is at tris[i], resizes to tris.size()
+        void fromtriangles(std::vector<vector3> const& positions, std::vector<uint> const& indices, std::vector<uint> const& tris);
+
+        // indices of the boxes in [first, first + num) overlapping box, in increasing order
+        // returns how many were written, out needs room for num rounded up to aabbkernels::width
+        uint overlaps(aabb const& box, uint first, uint num, uint* out) const;
+
+        // same over all boxes, out is resized to the overlaps
+        void overlaps(aabb const& box, std::vector<uint>& out) const;
+
+        uint count = 0;
+        std::vector<float> minx, miny, minz, maxx, maxy, maxz;
+    };
 }
\ No newline at end of file
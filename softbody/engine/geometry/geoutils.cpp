@@ -1,9 +1,15 @@
 #include "geoutils.h"
 
 #include "DirectXMath.h"
-#include "Engine/engineutils.h"
+#include "engine/engineutils.h"
 
 #include <array>
+#include <cmath>
+#include <limits>
+#include <ranges>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace DirectX;
 using namespace DirectX::SimpleMath;
@@ -39,7 +45,7 @@ std::array<vertex, 4> transform_unitquad(const vector3(&verts)[4], const vector3
     auto const angle = XMConvertToRadians(tx[0].Length());
     auto const axis = tx[0].Normalized();
 
-    for (uint i = 0; i < 4; ++i)
+    for (stdx::uint i = 0; i < 4; ++i)
     {
         vector3 normal;
         vector3 pos = { verts[i].x * scale.x, verts[i].y * scale.y, verts[i].z * scale.z };
@@ -144,9 +150,152 @@ std::vector<vector3> geoutils::create_cube_lines(vector3 const& center, float sc
     return create_box_lines(center, { scale, scale, scale });
 }
 
+std::vector<vector3> geoutils::fillwithspheres(geometry::aabb const& box, uint count, float radius)
+{
+    std::unordered_set<uint> occupied;
+    std::vector<vector3> spheres;
+
+    auto const roomspan = (box.span() - stdx::tolerance<vector3>);
+
+    assert(roomspan.x > 0.f);
+    assert(roomspan.y > 0.f);
+    assert(roomspan.z > 0.f);
+
+    uint const degree = static_cast<uint>(std::ceil(std::cbrt(count))) - 1;
+    uint const numcells = (degree + 1) * (degree + 1) * (degree + 1);
+    float const gridvol = numcells * 8 * (radius * radius * radius);
+
+    // find the size of largest cube that can be fit into box
+    float const cubelen = std::min({ roomspan.x, roomspan.y, roomspan.z });
+    float const celld = cubelen / (degree + 1);
+    float const cellr = celld / 2.f;;
+
+    // check if this box can contain all cells
+    assert(cubelen * cubelen * cubelen > gridvol);
+
+    vector3 const gridorigin = { box.center() - vector3(cubelen / 2.f) };
+    for (auto i : std::ranges::iota_view{ 0u,  count })
+    {
+        static auto& re = engineutils::getrandomengine();
+        std::uniform_int_distribution<uint> distvoxel(0u, numcells - 1);
+
+        uint emptycell = 0;
+        while (occupied.find(emptycell) != occupied.end()) emptycell = distvoxel(re);
+
+        occupied.insert(emptycell);
+
+        auto const thecell = stdx::grididx<2>::from1d(degree, emptycell);
+        spheres.emplace_back((vector3(thecell[0] * celld, thecell[2] * celld, thecell[1] * celld) + vector3(cellr)) + gridorigin);
+    }
+
+    return spheres;
+}
+
+indexedmesh geoutils::weld(std::vector<vertex> const& triangles, float _tolerance)
+{
+    // vertices are merged when all attributes fall in the same cell of a grid with _tolerance sized cells
+    // values straddling a cell boundary stay separate, which costs a duplicate but never merges distinct vertices
+    using cell = std::array<int32_t, 8>;
+    struct cellhash
+    {
+        std::size_t operator()(cell const& c) const
+        {
+            std::size_t h = 0;
+            for (auto const v : c) h = h * 31 + std::hash<int32_t>{}(v);
+            return h;
+        }
+    };
+
+    auto const quantize = [_tolerance](float v) { return static_cast<int32_t>(std::lround(v / _tolerance)); };
+
+    indexedmesh mesh;
+    std::vector<uint> remap(triangles.size());
+    std::unordered_map<cell, uint, cellhash> unique;
+    unique.reserve(triangles.size());
+    for (uint i = 0; i < triangles.size(); ++i)
+    {
+        auto const& v = triangles[i];
+        cell const key = { quantize(v.position.x), quantize(v.position.y), quantize(v.position.z), quantize(v.normal.x), quantize(v.normal.y), quantize(v.normal.z), quantize(v.texcoord.x), quantize(v.texcoord.y) };
+        auto const [found, inserted] = unique.try_emplace(key, static_cast<uint>(mesh.vertices.size()));
+        if (inserted) mesh.vertices.push_back(v);
+
+        remap[i] = found->second;
+    }
+
+    // drop triangles that welding collapsed
+    mesh.indices.reserve(triangles.size());
+    for (uint i = 0; i + 2 < triangles.size(); i += 3)
+    {
+        uint const i0 = remap[i], i1 = remap[i + 1], i2 = remap[i + 2];
+        if (i0 == i1 || i1 == i2 || i0 == i2) continue;
+
+        mesh.indices.insert(mesh.indices.end(), { i0, i1, i2 });
+    }
+
+    return mesh;
+}
+
+std::vector<vector3> geoutils::clusterpoints(std::vector<vector3> const& points, float radius, uint maxpoints)
+{
+    using cell = std::array<int32_t, 3>;
+    struct cellhash
+    {
+        std::size_t operator()(cell const& c) const { return (std::size_t(uint32_t(c[0])) * 73856093) ^ (std::size_t(uint32_t(c[1])) * 19349663) ^ (std::size_t(uint32_t(c[2])) * 83492791); }
+    };
+
+    struct cluster
+    {
+        vector3 sum;
+        uint count;
+    };
+
+    // cells as wide as a cluster, so points about radius from a cluster's center end up in it
+    auto const quantize = [cellsize = 2.f * radius](float v) { return static_cast<int32_t>(std::floor(v / cellsize)); };
+
+    // clusters are in the order their first point came in, so the result does not depend on the hashing
+    std::vector<cluster> clusters;
+    std::unordered_map<cell, uint, cellhash> cells;
+    cells.reserve(points.size());
+    for (auto const& p : points)
+    {
+        auto const [found, inserted] = cells.try_emplace(cell{ quantize(p.x), quantize(p.y), quantize(p.z) }, static_cast<uint>(clusters.size()));
+        if (inserted) clusters.push_back({ vector3::Zero, 0 });
+
+        clusters[found->second].sum += p;
+        clusters[found->second].count++;
+    }
+
+    std::vector<vector3> centers;
+    centers.reserve(clusters.size());
+    for (auto const& c : clusters)
+        centers.push_back(c.sum / static_cast<float>(c.count));
+
+    if (centers.size() <= maxpoints)
+        return centers;
+
+    std::vector<vector3> kept;
+    kept.reserve(maxpoints);
+    if (maxpoints == 0)
+        return kept;
+
+    // distance of each center to the closest kept one, updated as points are kept
+    std::vector<float> distances(centers.size(), std::numeric_limits<float>::max());
+    uint next = static_cast<uint>(std::ranges::max_element(clusters, {}, &cluster::count) - clusters.begin());
+    while (kept.size() < maxpoints)
+    {
+        kept.push_back(centers[next]);
+        for (uint i = 0; i < centers.size(); ++i)
+            distances[i] = std::min(distances[i], vector3::DistanceSquared(centers[i], kept.back()));
+
+        next = static_cast<uint>(std::ranges::max_element(distances) - distances.begin());
+    }
+
+    return kept;
+}
+
 bool geoutils::nearlyequal(arithmeticpure_c auto const& l, arithmeticpure_c auto const& r, float _tolerance) 
 { 
-    return std::fabsf(l - r) < _tolerance;
+    return std::fabs(l - r) < _tolerance;
 }
 
 bool geoutils::nearlyequal(vector2 const& l, vector2 const& r, float _tolerance)
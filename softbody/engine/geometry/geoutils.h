@@ -2,17 +2,25 @@
 
 #include "geocore.h"
 #include "stdx/stdx.h"
-#include "engine/SimpleMath.h"
+#include "engine/simplemath.h"
 
 #include <concepts>
 
 namespace geoutils
 {
+    using stdx::uint;
+
     vector4 create_vector4(vector3 const& v, float w = 1.f);
     matrix get_planematrix(vector3 const &translation, vector3 const &normal);
 	std::vector<geometry::vertex> create_cube(vector3 const& center, vector3 const& extents);
 	std::vector<vector3> create_box_lines(vector3 const &center, vector3 const& extents);
 	std::vector<vector3> create_cube_lines(vector3 const &center, float scale);
+	std::vector<vector3> fillwithspheres(geometry::aabb const& box, uint count, float radius);
+	geometry::indexedmesh weld(std::vector<geometry::vertex> const& triangles, float _tolerance = stdx::tolerance<float>);
+
+	// merges the points falling in each cell of a grid with cells 2 * radius wide into their mean, at most maxpoints are kept
+	// when there are more cells the fullest one is kept first, then repeatedly the one farthest from those kept
+	std::vector<vector3> clusterpoints(std::vector<vector3> const& points, float radius, uint maxpoints);
 	bool nearlyequal(stdx::arithmeticpure_c auto const& l, stdx::arithmeticpure_c auto const& r, float _tolerance = stdx::tolerance<float>);
 	bool nearlyequal(vector2 const& l, vector2 const& r, float _tolerance = stdx::tolerance<float>);
 	bool nearlyequal(vector3 const& l, vector3 const& r, float _tolerance = stdx::tolerance<float>);
@@ -0,0 +1,408 @@
+#include "gjk.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+using namespace geometry;
+
+namespace
+{
+    using stdx::uint;
+
+    // iterations are bounded, hulls of a few dozen points converge in far fewer
+    constexpr uint maxiterations = 64;
+
+    // the search stops when a support point gets closer to the origin than the current one by less than this relative amount
+    constexpr float relativetolerance = 1e-5f;
+
+    // hulls closer than this are treated as overlapping
+    constexpr float overlapdistance = 1e-5f;
+
+    // tetrahedra thinner than this relative to their longest edge are treated as flat
+    constexpr float flatness = 1e-4f;
+
+    // a point of the minkowski difference l - r and the points of the hulls it came from
+    struct point
+    {
+        vector3 w, l, r;
+    };
+
+    // the points supporting the closest point to the origin, weights are its barycentric coordinates
+    struct simplex
+    {
+        std::array<point, 4> pts;
+        std::array<float, 4> weights = {};
+        uint size = 0;
+
+        void set(std::initializer_list<std::pair<point, float>> ptweights)
+        {
+            size = 0;
+            for (auto const& [pt, weight] : ptweights)
+            {
+                pts[size] = pt;
+                weights[size++] = weight;
+            }
+        }
+
+        vector3 closest() const
+        {
+            vector3 r = vector3::Zero;
+            for (uint i = 0; i < size; ++i)
+                r += pts[i].w * weights[i];
+            return r;
+        }
+    };
+
+    // reduces the segment ab to the part closest to the origin
+    void closestsegment(simplex& s, point const& a, point const& b)
+    {
+        auto const ab = b.w - a.w;
+        float const lensq = ab.LengthSquared();
+        float const t = lensq > 0.f ? std::clamp(-a.w.Dot(ab) / lensq, 0.f, 1.f) : 0.f;
+        if (t <= 0.f)
+            s.set({ { a, 1.f } });
+        else if (t >= 1.f)
+            s.set({ { b, 1.f } });
+        else
+            s.set({ { a, 1.f - t }, { b, t } });
+    }
+
+    // reduces the triangle abc to the feature closest to the origin, the regions of real-time collision detection(ericson)
+    void closesttriangle(simplex& s, point const& a, point const& b, point const& c)
+    {
+        auto const ab = b.w - a.w, ac = c.w - a.w;
+        float const d1 = ab.Dot(-a.w), d2 = ac.Dot(-a.w);
+        if (d1 <= 0.f && d2 <= 0.f)
+            return s.set({ { a, 1.f } });
+
+        float const d3 = ab.Dot(-b.w), d4 = ac.Dot(-b.w);
+        if (d3 >= 0.f && d4 <= d3)
+            return s.set({ { b, 1.f } });
+
+        float const vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+        {
+            float const v = d1 / (d1 - d3);
+            return s.set({ { a, 1.f - v }, { b, v } });
+        }
+
+        float const d5 = ab.Dot(-c.w), d6 = ac.Dot(-c.w);
+        if (d6 >= 0.f && d5 <= d6)
+            return s.set({ { c, 1.f } });
+
+        float const vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+        {
+            float const w = d2 / (d2 - d6);
+            return s.set({ { a, 1.f - w }, { c, w } });
+        }
+
+        float const va = d3 * d6 - d5 * d4;
+        if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+        {
+            float const w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+            return s.set({ { b, 1.f - w }, { c, w } });
+        }
+
+        // a degenerate triangle has no area, its longest edge is as close as it gets
+        float const sum = va + vb + vc;
+        if (sum <= 0.f)
+        {
+            float const ablen = ab.LengthSquared(), aclen = ac.LengthSquared(), bclen = (c.w - b.w).LengthSquared();
+            if (ablen >= aclen && ablen >= bclen)
+                closestsegment(s, a, b);
+            else if (aclen >= bclen)
+                closestsegment(s, a, c);
+            else
+                closestsegment(s, b, c);
+            return;
+        }
+
+        float const v = vb / sum, w = vc / sum;
+        s.set({ { a, 1.f - v - w }, { b, v }, { c, w } });
+    }
+
+    // reduces the tetrahedron to the face closest to the origin, false when the origin is inside
+    bool closesttetrahedron(simplex& s)
+    {
+        auto const [a, b, c, d] = s.pts;
+        std::array<std::array<point, 4>, 4> const faces = { { { a, b, c, d }, { a, c, d, b }, { a, d, b, c }, { b, d, c, a } } };
+
+        // the side of a face the origin is on cannot be told on a tetrahedron this flat, so the origin is taken to be outside all of them
+        auto const abc = (b.w - a.w).Cross(c.w - a.w);
+        float const longest = std::max({ (b.w - a.w).Length(), (c.w - a.w).Length(), (d.w - a.w).Length() });
+        bool const flat = std::fabs(abc.Dot(d.w - a.w)) <= flatness * abc.Length() * longest;
+
+        bool outside = false;
+        float bestsq = std::numeric_limits<float>::max();
+        simplex best;
+        for (auto const& [p0, p1, p2, opposite] : faces)
+        {
+            // the origin and the opposite vertex on different sides of the face
+            auto const n = (p1.w - p0.w).Cross(p2.w - p0.w);
+            if (!flat && n.Dot(-p0.w) * n.Dot(opposite.w - p0.w) > 0.f)
+                continue;
+
+            outside = true;
+            simplex face;
+            closesttriangle(face, p0, p1, p2);
+            float const distsq = face.closest().LengthSquared();
+            if (distsq < bestsq)
+            {
+                bestsq = distsq;
+                best = face;
+            }
+        }
+
+        if (outside)
+            s = best;
+        return outside;
+    }
+
+    point supportpoint(gjk::hull const& l, gjk::hull const& r, vector3 const& dir)
+    {
+        auto const lp = l.support(dir), rp = r.support(-dir);
+        return { lp - rp, lp, rp };
+    }
+
+    // the simplex is kept in the result, so penetration can expand it without solving again
+    gjk::separation withsimplex(gjk::separation result, simplex const& s)
+    {
+        for (uint i = 0; i < s.size; ++i)
+        {
+            result.lsimplex[i] = s.pts[i].l;
+            result.rsimplex[i] = s.pts[i].r;
+        }
+
+        result.simplexsize = s.size;
+        return result;
+    }
+
+    // gjk, the result is left with the simplex closest to the origin, which holds the origin when the hulls overlap
+    gjk::separation solve(gjk::hull const& l, gjk::hull const& r, vector3 const& searchdir)
+    {
+        if (l.points.empty() || r.points.empty())
+            return { false, std::numeric_limits<float>::max() };
+
+        simplex s;
+        s.set({ { supportpoint(l, r, searchdir == vector3::Zero ? r.offset - l.offset : searchdir), 1.f } });
+        vector3 v = s.closest();
+        for (uint iter = 0; iter < maxiterations; ++iter)
+        {
+            float const vsq = v.LengthSquared();
+            if (vsq <= overlapdistance * overlapdistance)
+                return withsimplex({ true }, s);
+
+            // the support point against v is no closer than v, so v is the closest point of the difference
+            auto const w = supportpoint(l, r, -v);
+            if (vsq - v.Dot(w.w) <= relativetolerance * vsq)
+                break;
+
+            // a point already in the simplex means no progress is left
+            if (std::ranges::any_of(std::span(s.pts.data(), s.size), [&w](point const& p) { return p.w == w.w; }))
+                break;
+
+            auto const previous = s;
+            s.pts[s.size++] = w;
+            switch (s.size)
+            {
+            case 2: closestsegment(s, s.pts[0], s.pts[1]); break;
+            case 3: closesttriangle(s, s.pts[0], s.pts[1], s.pts[2]); break;
+            default:
+                if (!closesttetrahedron(s))
+                    return withsimplex({ true }, s);
+            }
+
+            // rounding can stall the search, the last simplex stands when the new one is no closer
+            auto const next = s.closest();
+            if (next.LengthSquared() >= vsq)
+            {
+                s = previous;
+                break;
+            }
+
+            v = next;
+        }
+
+        gjk::separation result;
+        for (uint i = 0; i < s.size; ++i)
+        {
+            result.lpoint += s.pts[i].l * s.weights[i];
+            result.rpoint += s.pts[i].r * s.weights[i];
+        }
+
+        result.distance = v.Length();
+        return withsimplex(result, s);
+    }
+
+    // the shortest of the translations along the axes and the offset that separate the hulls, for when there is no polytope to expand
+    vector3 separatingaxis(gjk::hull const& l, gjk::hull const& r)
+    {
+        auto const offset = r.offset - l.offset;
+        std::array<vector3, 4> const axes = { vector3::UnitX, vector3::UnitY, vector3::UnitZ, offset == vector3::Zero ? vector3::UnitX : offset.Normalized() };
+
+        vector3 best = vector3::Zero;
+        float bestdepth = std::numeric_limits<float>::max();
+        for (auto const& axis : axes)
+        {
+            for (auto const& dir : { axis, -axis })
+            {
+                // moving l along dir by the overlap of the projections separates them on dir
+                float const depth = r.support(dir).Dot(dir) - l.support(-dir).Dot(dir);
+                if (depth < bestdepth)
+                {
+                    bestdepth = depth;
+                    best = dir * std::max(depth, 0.f);
+                }
+            }
+        }
+
+        return best;
+    }
+
+    // epa, grows the simplex holding the origin towards the boundary of the difference closest to the origin
+    vector3 expand(gjk::hull const& l, gjk::hull const& r, simplex const& s)
+    {
+        std::vector<point> verts(s.pts.begin(), s.pts.begin() + s.size);
+        auto const isnew = [&verts](point const& p) { return std::ranges::none_of(verts, [&p](point const& v) { return vector3::DistanceSquared(v.w, p.w) <= overlapdistance * overlapdistance; }); };
+
+        // gjk can stop on a point, segment or triangle through the origin, support points off it make a tetrahedron
+        std::array<vector3, 6> const axes = { vector3::UnitX, -vector3::UnitX, vector3::UnitY, -vector3::UnitY, vector3::UnitZ, -vector3::UnitZ };
+        for (uint i = 0; verts.size() < 4 && i < axes.size(); ++i)
+        {
+            vector3 dir = axes[i];
+            if (verts.size() == 2)
+                dir = (verts[1].w - verts[0].w).Cross(axes[i]);
+            else if (verts.size() == 3)
+                dir = (verts[1].w - verts[0].w).Cross(verts[2].w - verts[0].w) * (i % 2 == 0 ? 1.f : -1.f);
+
+            if (dir.LengthSquared() <= 0.f)
+                continue;
+
+            auto const p = supportpoint(l, r, dir);
+            bool const offplane = verts.size() < 3 || std::fabs(dir.Normalized().Dot(p.w - verts[0].w)) > overlapdistance;
+            if (isnew(p) && offplane)
+                verts.push_back(p);
+        }
+
+        if (verts.size() < 4 || std::fabs((verts[1].w - verts[0].w).Cross(verts[2].w - verts[0].w).Dot(verts[3].w - verts[0].w)) <= overlapdistance * overlapdistance * overlapdistance)
+            return separatingaxis(l, r);
+
+        // faces point away from a point inside the polytope, the polytope only grows so it stays inside
+        auto const inside = (verts[0].w + verts[1].w + verts[2].w + verts[3].w) / 4.f;
+
+        struct face
+        {
+            uint a, b, c;
+            vector3 normal;
+            float distance;
+        };
+
+        std::vector<face> faces;
+        auto const addface = [&](uint a, uint b, uint c)
+        {
+            auto n = (verts[b].w - verts[a].w).Cross(verts[c].w - verts[a].w);
+            float const len = n.Length();
+            if (len <= 0.f)
+                return;
+
+            n /= len;
+            if (n.Dot(inside - verts[a].w) > 0.f)
+            {
+                std::swap(b, c);
+                n = -n;
+            }
+
+            faces.push_back({ a, b, c, n, n.Dot(verts[a].w) });
+        };
+
+        addface(0, 1, 2);
+        addface(0, 3, 1);
+        addface(0, 2, 3);
+        addface(1, 3, 2);
+
+        std::vector<std::pair<uint, uint>> horizon;
+        face closest = {};
+        for (uint iter = 0; iter < maxiterations && !faces.empty(); ++iter)
+        {
+            closest = *std::ranges::min_element(faces, {}, &face::distance);
+
+            // the boundary is reached when the support point along the closest face's normal is no farther than the face
+            auto const w = supportpoint(l, r, closest.normal);
+            if (w.w.Dot(closest.normal) - closest.distance <= relativetolerance * std::max(closest.distance, 1.f))
+                break;
+
+            // faces seen from w go, the edges they do not share with each other are the horizon w is joined to
+            horizon.clear();
+            std::erase_if(faces, [&](face const& f)
+            {
+                if (f.normal.Dot(w.w - verts[f.a].w) <= 0.f)
+                    return false;
+
+                for (auto const& edge : { std::pair{ f.a, f.b }, std::pair{ f.b, f.c }, std::pair{ f.c, f.a } })
+                {
+                    auto const shared = std::ranges::find(horizon, std::pair{ edge.second, edge.first });
+                    if (shared != horizon.end())
+                        horizon.erase(shared);
+                    else
+                        horizon.push_back(edge);
+                }
+
+                return true;
+            });
+
+            if (horizon.empty())
+                break;
+
+            verts.push_back(w);
+            for (auto const& [a, b] : horizon)
+                addface(a, b, static_cast<uint>(verts.size()) - 1);
+        }
+
+        // moving l against the normal of the closest face by its distance moves the boundary of the difference onto the origin
+        return faces.empty() ? separatingaxis(l, r) : -closest.normal * closest.distance;
+    }
+}
+
+
+vector3 geometry::gjk::hull::support(vector3 const& dir) const
+{
+    vector3 best = points[0];
+    float bestdot = best.Dot(dir);
+    for (auto const& p : points.subspan(1))
+    {
+        float const d = p.Dot(dir);
+        if (d > bestdot)
+        {
+            bestdot = d;
+            best = p;
+        }
+    }
+
+    return best + offset;
+}
+
+geometry::gjk::separation geometry::gjk::distance(hull const& l, hull const& r, vector3 const& searchdir)
+{
+    return solve(l, r, searchdir);
+}
+
+vector3 geometry::gjk::penetration(hull const& l, hull const& r, vector3 const& searchdir)
+{
+    return penetration(l, r, solve(l, r, searchdir));
+}
+
+vector3 geometry::gjk::penetration(hull const& l, hull const& r, separation const& sep)
+{
+    if (!sep.overlap)
+        return vector3::Zero;
+
+    simplex s;
+    for (uint i = 0; i < sep.simplexsize; ++i)
+        s.pts[i] = { sep.lsimplex[i] - sep.rsimplex[i], sep.lsimplex[i], sep.rsimplex[i] };
+    s.size = sep.simplexsize;
+
+    return expand(l, r, s);
+}
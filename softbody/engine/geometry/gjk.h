@@ -0,0 +1,47 @@
+#pragma once
+
+#include "stdx/stdx.h"
+#include "engine/core.h"
+
+#include <span>
+#include <array>
+
+// distance between convex hulls of point sets by gilbert johnson keerthi and their penetration by expanding polytopes
+// the hulls are only ever seen through their support points
+namespace geometry::gjk
+{
+    using stdx::uint;
+
+    // the convex hull of points moved by offset, e.g. a control net around the center of its body
+    struct hull
+    {
+        std::span<vector3 const> points;
+        vector3 offset = {};
+
+        // the point of the hull farthest along dir
+        vector3 support(vector3 const& dir) const;
+    };
+
+    struct separation
+    {
+        // the hulls overlap, the rest is only valid when they do not
+        bool overlap = false;
+        float distance = 0.f;
+
+        // the closest points of the hulls, lpoint - rpoint is the shortest translation apart
+        vector3 lpoint = {}, rpoint = {};
+
+        // the points of each hull making up the simplex the search ended on, it holds the origin when the hulls overlap
+        std::array<vector3, 4> lsimplex = {}, rsimplex = {};
+        uint simplexsize = 0;
+    };
+
+    // searchdir is roughly the direction from l to r to start looking along, e.g. rpoint - lpoint of the pair's last query, by default the offset between the hulls
+    separation distance(hull const& l, hull const& r, vector3 const& searchdir = {});
+
+    // the shortest translation of l that separates the hulls, zero when they do not overlap
+    vector3 penetration(hull const& l, hull const& r, vector3 const& searchdir = {});
+
+    // the same from the result of distance for the same hulls, the expansion starts from its simplex instead of solving again
+    vector3 penetration(hull const& l, hull const& r, separation const& sep);
+}
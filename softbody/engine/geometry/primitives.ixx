@@ -2,9 +2,12 @@ module;
 
 #include "geocore.h"
 #include "geoutils.h"
+#include "tritri.h"
 #include "stdx/stdx.h"
 
+#include <limits>
 #include <optional>
+#include <algorithm>
 
 export module primitives;
 
@@ -12,6 +15,8 @@ using namespace DirectX;
 
 export namespace geometry
 {
+using stdx::uint;
+
 struct line2D
 {
     line2D() = default;
@@ -127,66 +132,78 @@ struct triangle
 
     static std::optional<linesegment> intersect(triangle const& t0, triangle const& t1) { return intersect(t0.verts, t1.verts); }
 
+    // moller's interval test, the segment is where the intervals of both triangles on the line the planes meet on overlap
+    // same test as the tritri kernels, which filter the pairs this is called for, coplanar triangles have no segment
     static std::optional<linesegment> intersect(vector3 const* t0, vector3 const* t1)
     {
-        vector3 const t0_normal = (t0[1] - t0[0]).Cross(t0[2] - t0[0]).Normalized();
-        vector3 const t1_normal = (t1[1] - t1[0]).Cross(t1[2] - t1[0]).Normalized();
-
-        // construct third plane as cross product of the two plane normals and passing through origin
-        auto const linedir = t0_normal.Cross(t1_normal).Normalized();
-
-        // use 3 plane intersection to find a point on the inerseciton line
-        auto const det = matrix(t0_normal, t1_normal, linedir).Determinant();
-
-        if (fabs(det) < FLT_EPSILON)
+        // distances of the vertices of tri to the plane of other, small ones snapped to 0
+        auto const planedistances = [](vector3 const* other, vector3 const* tri, vector3& normal, float (&dist)[3])
+        {
+            normal = (other[1] - other[0]).Cross(other[2] - other[0]);
+            for (uint v = 0; v < 3; ++v)
+            {
+                dist[v] = normal.Dot(tri[v] - other[0]);
+                if (std::fabs(dist[v]) < tritri::epsilon) dist[v] = 0.f;
+            }
+        };
+
+        auto const oneside = [](float const (&dist)[3]) { return dist[0] * dist[1] > 0.f && dist[0] * dist[2] > 0.f; };
+        auto const onplane = [](float const (&dist)[3]) { return dist[0] == 0.f && dist[1] == 0.f && dist[2] == 0.f; };
+
+        vector3 n0, n1;
+        float d0[3], d1[3];
+        planedistances(t1, t0, n1, d0);
+        if (oneside(d0))
             return {};
 
-        vector3 const& linepoint0 = (t0[0].Dot(t0_normal) * (t1_normal.Cross(linedir)) + t1[0].Dot(t1_normal) * linedir.Cross(t0_normal)) / det;
-
-        line const isect_line{ linepoint0, linedir };
-
-        std::vector<line> edges;
-        edges.reserve(6);
-
-        edges.emplace_back(line{ t0[0], (t0[1] - t0[0]).Normalized() });
-        edges.emplace_back(line{ t0[1], (t0[2] - t0[1]).Normalized() });
-        edges.emplace_back(line{ t0[2], (t0[0] - t0[2]).Normalized() });
-
-        edges.emplace_back(line{ t1[0], (t1[1] - t1[0]).Normalized() });
-        edges.emplace_back(line{ t1[1], (t1[2] - t1[1]).Normalized() });
-        edges.emplace_back(line{ t1[2], (t1[0] - t1[2]).Normalized() });
-
-        std::vector<vector3> isect_linesegment;
-        isect_linesegment.reserve(2);
+        planedistances(t0, t1, n0, d1);
+        if (oneside(d1) || onplane(d0) || onplane(d1))
+            return {};
 
-        for (auto const& edge : edges)
+        struct interval
         {
-            // ignore intersections with parallel edge
-            if (geoutils::nearlyequal(std::fabsf(edge.dir.Dot(isect_line.dir)), 1.f))
-                continue;
-
-            // the points on intersection of two triangles will be on both triangles
-            if (auto isect = line::intersect_lines(edge, isect_line); isect.has_value() && triangle::isin(t0, isect.value()) && triangle::isin(t1, isect.value()))
-                isect_linesegment.push_back(isect.value());
-        }
-
-        // remove duplicates, naively, maybe improve this
-        for (uint i = 0; i < std::max(uint(1), isect_linesegment.size()) - 1; ++i)
-            for (uint j = i + 1; j < isect_linesegment.size(); ++j)
-                if (geoutils::nearlyequal(isect_linesegment[i], isect_linesegment[j]))
+            float min = std::numeric_limits<float>::max(), max = std::numeric_limits<float>::lowest();
+            vector3 minpoint, maxpoint;
+
+            void add(float t, vector3 const& point)
+            {
+                if (t < min) min = t, minpoint = point;
+                if (t > max) max = t, maxpoint = point;
+            }
+        };
+
+        // the vertices on the other plane and the points where edges cross it, parametrized along dir
+        vector3 const dir = n0.Cross(n1);
+        auto const lineinterval = [&dir](vector3 const* tri, float const (&dist)[3])
+        {
+            interval r;
+            for (uint v = 0; v < 3; ++v)
+            {
+                if (dist[v] == 0.f)
+                    r.add(dir.Dot(tri[v]), tri[v]);
+
+                uint const w = (v + 1) % 3;
+                if (dist[v] * dist[w] < 0.f)
                 {
-                    std::swap(isect_linesegment[j], isect_linesegment[isect_linesegment.size() - 1]);
-                    isect_linesegment.pop_back();
-                    j--;
+                    vector3 const point = tri[v] + (tri[w] - tri[v]) * (dist[v] / (dist[v] - dist[w]));
+                    r.add(dir.Dot(point), point);
                 }
+            }
 
-        if (isect_linesegment.size() < 2)
+            return r;
+        };
+
+        auto const i0 = lineinterval(t0, d0);
+        auto const i1 = lineinterval(t1, d1);
+        if (std::max(i0.min, i1.min) > std::min(i0.max, i1.max))
             return {};
 
-        // bug : this can sometimes be invalid, only when frame time is high?
-        // assert(isect_linesegment.size() != 2);
+        vector3 const start = i0.min > i1.min ? i0.minpoint : i1.minpoint;
+        vector3 const end = i0.max < i1.max ? i0.maxpoint : i1.maxpoint;
+        if (geoutils::nearlyequal(start, end))
+            return {};
 
-        return { { isect_linesegment[0], isect_linesegment[1] } };
+        return { { start, end } };
     }
 
     static bool isin(vector3 const* tri, vector3 const& point)
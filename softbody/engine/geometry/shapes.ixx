@@ -4,8 +4,7 @@ module;
 #include "geoutils.h"
 #include "stdx/stdx.h"
 #include "stdx/vec.h"
-#include "engine/graphics/gfxcore.h"
-#include "engine/graphics/globalresources.h"
+#include "engine/graphics/gfxfwd.h"
 
 #include <utility>
 #include <vector>
@@ -15,8 +14,12 @@ module;
 
 export module shapes;
 
+using namespace DirectX;
+
 export namespace geometry
 {
+using stdx::uint;
+
 struct rectangle
 {
     std::vector<geometry::vertex> triangles() const
@@ -44,13 +47,13 @@ struct circle
     {
         std::vector<vector3> vertices;
 
-        float x0 = radius * std::cosf(0);
-        float y0 = radius * std::sinf(0);
+        float x0 = radius * std::cos(0.f);
+        float y0 = radius * std::sin(0.f);
 
         for (float t = step; t <= (XM_2PI + step); t += step)
         {
-            float const x = radius * std::cosf(t);
-            float const y = radius * std::sinf(t);
+            float const x = radius * std::cos(t);
+            float const y = radius * std::sin(t);
 
             vertices.push_back(vector3::Zero);
             vertices.push_back({ x, y , 0.f });
@@ -117,7 +120,8 @@ struct cube
         return invertedvertices;
     }
 
-    std::vector<gfx::instance_data> instancedata() const { return { gfx::instance_data(matrix::CreateTranslation(center), gfx::globalresources::get().view(), gfx::globalresources::get().mat(""))}; }
+    // defined alongside the renderer so that shapes do not depend on d3d12
+    std::vector<gfx::instance_data> instancedata() const;
 
 private:
     vector3 center, extents;
@@ -241,7 +245,7 @@ private:
             }
     }
 
-    static vector3 spherevertex(float const phi, float const theta) { return { std::sinf(theta) * std::cosf(phi), std::cosf(theta), std::sinf(theta) * std::sinf(phi) }; }
+    static vector3 spherevertex(float const phi, float const theta) { return { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) }; }
 
     std::vector<vertex> triangulated_sphere;
     std::vector<polar_coords> triangulated_sphere_polar;
@@ -0,0 +1,115 @@
+#include "tritri.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// portable fallback, softbody_bench_beziermaths compares the avx2 kernel to it
+namespace
+{
+using stdx::uint;
+
+using namespace geometry::tritri;
+
+struct interval
+{
+    float min = std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::lowest();
+};
+
+float dot(float const* l, float const* r) { return l[0] * r[0] + l[1] * r[1] + l[2] * r[2]; }
+
+void cross(float const* l, float const* r, float* res)
+{
+    res[0] = l[1] * r[2] - l[2] * r[1];
+    res[1] = l[2] * r[0] - l[0] * r[2];
+    res[2] = l[0] * r[1] - l[1] * r[0];
+}
+
+// distances of the 3 vertices of tri(9 floats) to the plane of other, small ones snapped to 0
+void planedistances(float const* other, float const* tri, float* normal, float* dist)
+{
+    float const e0[3] = { other[3] - other[0], other[4] - other[1], other[5] - other[2] };
+    float const e1[3] = { other[6] - other[0], other[7] - other[1], other[8] - other[2] };
+    cross(e0, e1, normal);
+
+    for (uint v = 0; v < 3; ++v)
+    {
+        float const rel[3] = { tri[v * 3] - other[0], tri[v * 3 + 1] - other[1], tri[v * 3 + 2] - other[2] };
+        dist[v] = dot(normal, rel);
+        if (std::fabs(dist[v]) < epsilon) dist[v] = 0.f;
+    }
+}
+
+// interval of tri on the line where the planes meet, from the vertices on the other plane and the edges crossing it
+interval lineinterval(float const* proj, float const* dist)
+{
+    interval r;
+    for (uint v = 0; v < 3; ++v)
+    {
+        if (dist[v] == 0.f)
+            r.min = std::min(r.min, proj[v]), r.max = std::max(r.max, proj[v]);
+
+        uint const w = (v + 1) % 3;
+        if (dist[v] * dist[w] < 0.f)
+        {
+            float const t = proj[v] + (proj[w] - proj[v]) * (dist[v] / (dist[v] - dist[w]));
+            r.min = std::min(r.min, t), r.max = std::max(r.max, t);
+        }
+    }
+
+    return r;
+}
+
+bool overlap(float const* t0, float const* t1)
+{
+    float n0[3], n1[3], d0[3], d1[3];
+    planedistances(t1, t0, n1, d0);
+    if (d0[0] * d0[1] > 0.f && d0[0] * d0[2] > 0.f)
+        return false;
+
+    planedistances(t0, t1, n0, d1);
+    if (d1[0] * d1[1] > 0.f && d1[0] * d1[2] > 0.f)
+        return false;
+
+    // coplanar, or one of them is degenerate
+    if ((d0[0] == 0.f && d0[1] == 0.f && d0[2] == 0.f) || (d1[0] == 0.f && d1[1] == 0.f && d1[2] == 0.f))
+        return false;
+
+    float dir[3];
+    cross(n0, n1, dir);
+
+    float const proj0[3] = { dot(dir, t0), dot(dir, t0 + 3), dot(dir, t0 + 6) };
+    float const proj1[3] = { dot(dir, t1), dot(dir, t1 + 3), dot(dir, t1 + 6) };
+    auto const i0 = lineinterval(proj0, d0);
+    auto const i1 = lineinterval(proj1, d1);
+    return std::max(i0.min, i1.min) <= std::min(i0.max, i1.max);
+}
+
+uint overlaps(float const* tri, candidates const& c)
+{
+    uint mask = 0;
+    for (uint i = 0; i < c.count; ++i)
+    {
+        float const candidate[9] = { c.coords[0][0][i], c.coords[0][1][i], c.coords[0][2][i], c.coords[1][0][i], c.coords[1][1][i], c.coords[1][2][i], c.coords[2][0][i], c.coords[2][1][i], c.coords[2][2][i] };
+        if (overlap(tri, candidate)) mask |= 1u << i;
+    }
+
+    return mask;
+}
+}
+
+namespace geometry::tritri
+{
+table const& scalar()
+{
+    static table const t{ simd::isa::scalar, overlaps };
+    return t;
+}
+
+table const& active()
+{
+    static table const& t = simd::active() >= simd::isa::avx2 ? avx2() : scalar();
+    return t;
+}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "stdx/stdxcore.h"
+#include "engine/simd.h"
+
+// triangle triangle overlap in the style of moller's interval test, one triangle against a batch of candidates
+namespace geometry::tritri
+{
+using stdx::uint;
+
+// candidates per batch, one avx2 register of lanes
+inline constexpr uint width = 8;
+
+// signed distances to the other triangle's plane below this are treated as 0, distances scale with the area of that triangle
+inline constexpr float epsilon = 1e-6f;
+
+// structure of arrays, coords[v][c][i] is coordinate c of vertex v of candidate i, lanes from count on are ignored
+struct candidates
+{
+    alignas(32) float coords[3][3][width];
+    uint count = 0;
+};
+
+// tri is 3 vertices of 3 floats, bit i of the result is set when tri overlaps candidate i
+// coplanar triangles do not overlap, the same as triangle::intersect
+using overlaps_fn = uint(*)(float const* tri, candidates const& c);
+
+struct table
+{
+    simd::isa isa;
+    overlaps_fn overlaps;
+};
+
+table const& scalar();
+table const& avx2();
+
+// table for simd::active()
+table const& active();
+}
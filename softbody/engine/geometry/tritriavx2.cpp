@@ -0,0 +1,117 @@
+#include "tritri.h"
+
+#include <limits>
+#include <immintrin.h>
+
+// 8 candidates per register, this file is built with /arch:AVX2
+// the same test as the scalar kernel without its early outs, every lane runs all of it and the masks decide
+namespace
+{
+using stdx::uint;
+
+using namespace geometry::tritri;
+
+struct vec8
+{
+    __m256 x, y, z;
+};
+
+__m256 dot(vec8 const& l, vec8 const& r) { return _mm256_fmadd_ps(l.x, r.x, _mm256_fmadd_ps(l.y, r.y, _mm256_mul_ps(l.z, r.z))); }
+
+vec8 sub(vec8 const& l, vec8 const& r) { return { _mm256_sub_ps(l.x, r.x), _mm256_sub_ps(l.y, r.y), _mm256_sub_ps(l.z, r.z) }; }
+
+vec8 cross(vec8 const& l, vec8 const& r)
+{
+    return { _mm256_fmsub_ps(l.y, r.z, _mm256_mul_ps(l.z, r.y)), _mm256_fmsub_ps(l.z, r.x, _mm256_mul_ps(l.x, r.z)), _mm256_fmsub_ps(l.x, r.y, _mm256_mul_ps(l.y, r.x)) };
+}
+
+vec8 broadcast(float const* v) { return { _mm256_set1_ps(v[0]), _mm256_set1_ps(v[1]), _mm256_set1_ps(v[2]) }; }
+
+vec8 load(candidates const& c, uint v) { return { _mm256_load_ps(c.coords[v][0]), _mm256_load_ps(c.coords[v][1]), _mm256_load_ps(c.coords[v][2]) }; }
+
+// distances of the vertices of tri to the plane of other, small ones snapped to 0
+void planedistances(vec8 const (&other)[3], vec8 const (&tri)[3], vec8& normal, __m256 (&dist)[3])
+{
+    normal = cross(sub(other[1], other[0]), sub(other[2], other[0]));
+
+    __m256 const eps = _mm256_set1_ps(epsilon);
+    __m256 const absmask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    for (uint v = 0; v < 3; ++v)
+    {
+        __m256 const dv = dot(normal, sub(tri[v], other[0]));
+        dist[v] = _mm256_and_ps(dv, _mm256_cmp_ps(_mm256_and_ps(dv, absmask), eps, _CMP_GE_OQ));
+    }
+}
+
+// lanes whose vertices all lie strictly on one side of the plane
+__m256 oneside(__m256 const (&dist)[3])
+{
+    __m256 const zero = _mm256_setzero_ps();
+    __m256 const s01 = _mm256_cmp_ps(_mm256_mul_ps(dist[0], dist[1]), zero, _CMP_GT_OQ);
+    __m256 const s02 = _mm256_cmp_ps(_mm256_mul_ps(dist[0], dist[2]), zero, _CMP_GT_OQ);
+    return _mm256_and_ps(s01, s02);
+}
+
+// lanes whose vertices all lie on the plane
+__m256 onplane(__m256 const (&dist)[3])
+{
+    __m256 const zero = _mm256_setzero_ps();
+    return _mm256_and_ps(_mm256_cmp_ps(dist[0], zero, _CMP_EQ_OQ), _mm256_and_ps(_mm256_cmp_ps(dist[1], zero, _CMP_EQ_OQ), _mm256_cmp_ps(dist[2], zero, _CMP_EQ_OQ)));
+}
+
+// interval of the triangle on the line where the planes meet, lanes without a vertex on the plane or a crossing edge keep an empty one
+void lineinterval(__m256 const (&proj)[3], __m256 const (&dist)[3], __m256& min, __m256& max)
+{
+    __m256 const zero = _mm256_setzero_ps();
+    __m256 const inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256 const neginf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    min = inf, max = neginf;
+    for (uint v = 0; v < 3; ++v)
+    {
+        uint const w = (v + 1) % 3;
+
+        __m256 const onv = _mm256_cmp_ps(dist[v], zero, _CMP_EQ_OQ);
+        min = _mm256_min_ps(min, _mm256_blendv_ps(inf, proj[v], onv));
+        max = _mm256_max_ps(max, _mm256_blendv_ps(neginf, proj[v], onv));
+
+        // the division is only used in the lanes where the edge crosses, so its denominator is not 0 there
+        __m256 const crosses = _mm256_cmp_ps(_mm256_mul_ps(dist[v], dist[w]), zero, _CMP_LT_OQ);
+        __m256 const t = _mm256_fmadd_ps(_mm256_sub_ps(proj[w], proj[v]), _mm256_div_ps(dist[v], _mm256_sub_ps(dist[v], dist[w])), proj[v]);
+        min = _mm256_min_ps(min, _mm256_blendv_ps(inf, t, crosses));
+        max = _mm256_max_ps(max, _mm256_blendv_ps(neginf, t, crosses));
+    }
+}
+
+uint overlaps(float const* tri, candidates const& c)
+{
+    vec8 const t0[3] = { broadcast(tri), broadcast(tri + 3), broadcast(tri + 6) };
+    vec8 const t1[3] = { load(c, 0), load(c, 1), load(c, 2) };
+
+    vec8 n0, n1;
+    __m256 d0[3], d1[3];
+    planedistances(t1, t0, n1, d0);
+    planedistances(t0, t1, n0, d1);
+
+    __m256 const rejected = _mm256_or_ps(_mm256_or_ps(oneside(d0), oneside(d1)), _mm256_or_ps(onplane(d0), onplane(d1)));
+
+    vec8 const dir = cross(n0, n1);
+    __m256 const proj0[3] = { dot(dir, t0[0]), dot(dir, t0[1]), dot(dir, t0[2]) };
+    __m256 const proj1[3] = { dot(dir, t1[0]), dot(dir, t1[1]), dot(dir, t1[2]) };
+
+    __m256 min0, max0, min1, max1;
+    lineinterval(proj0, d0, min0, max0);
+    lineinterval(proj1, d1, min1, max1);
+
+    __m256 const overlap = _mm256_andnot_ps(rejected, _mm256_cmp_ps(_mm256_max_ps(min0, min1), _mm256_min_ps(max0, max1), _CMP_LE_OQ));
+    return static_cast<uint>(_mm256_movemask_ps(overlap)) & ((1u << c.count) - 1);
+}
+}
+
+namespace geometry::tritri
+{
+table const& avx2()
+{
+    static table const t{ simd::isa::avx2, overlaps };
+    return t;
+}
+}
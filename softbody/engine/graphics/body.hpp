@@ -74,6 +74,14 @@ namespace gfx
         dispatch(bindings, params.wireframe, gfx::globalresources::get().mat(getparams().matname).ex(), numasthreads);
     }
 
+    // bodies stepped at a fixed rate are drawn between their last two states
+    template<typename body_t>
+    vector3 drawcenter(body_t const& body)
+    {
+        if constexpr (requires { body.drawcenter(); }) return body.drawcenter();
+        else return body.center();
+    }
+
     template<dbody_c body_t, topology prim_t>
     inline body_dynamic<body_t, prim_t>::body_dynamic(rawbody_t _body, bodyparams const& _params, stdx::vecui2 texdims)  : bodyinterface(_params), body(std::move(_body))
     {
@@ -119,7 +127,7 @@ namespace gfx
 
         _vertexbuffer.updateresource(get_vertices(body));
         _texture.updateresource(body.texturedata());
-        _cbuffer.updateresource(objectconstants{ matrix::CreateTranslation(body.center()), globalresources::get().view(), globalresources::get().mat(getparams().matname) });
+        _cbuffer.updateresource(objectconstants{ matrix::CreateTranslation(drawcenter(body)), globalresources::get().view(), globalresources::get().mat(getparams().matname) });
         assert(_vertexbuffer.count() < ASGROUP_SIZE * MAX_MSGROUPS_PER_ASGROUP * topologyconstants<prim_t>::maxprims_permsgroup * topologyconstants<prim_t>::numverts_perprim);
         
         dispatchparams dispatch_params;
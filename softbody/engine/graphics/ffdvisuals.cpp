@@ -0,0 +1,15 @@
+#include "engine/geometry/ffd.h"
+#include "gfxcore.h"
+#include "globalresources.h"
+
+#include <vector>
+
+using namespace geometry;
+
+std::vector<gfx::instance_data> ffd_object::controlnet_instancedata() const
+{
+    std::vector<gfx::instance_data> instances_info;
+    instances_info.reserve(ffd_world::numcontrolpts);
+    for (auto const& ctrl_pt : ctrlpts()) { instances_info.emplace_back(matrix::CreateTranslation(ctrl_pt + center()), gfx::globalresources::get().view(), gfx::globalresources::get().mat("")); }
+    return instances_info;
+}
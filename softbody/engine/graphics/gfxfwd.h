@@ -0,0 +1,7 @@
+#pragma once
+
+// forward declarations for simulation code that hands data to the renderer but must not depend on d3d12
+namespace gfx
+{
+    struct instance_data;
+}
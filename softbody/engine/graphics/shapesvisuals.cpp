@@ -0,0 +1,10 @@
+module;
+
+#include "gfxcore.h"
+#include "globalresources.h"
+
+#include <vector>
+
+module shapes;
+
+std::vector<gfx::instance_data> geometry::cube::instancedata() const { return { gfx::instance_data(matrix::CreateTranslation(center), gfx::globalresources::get().view(), gfx::globalresources::get().mat(""))}; }
@@ -1,5 +1,626 @@
 #include "collision.h"
 
-void collision::spatial_partition::update(std::vector<vector3> const& tris, float dt)
+#include <bit>
+#include <cmath>
+#include <algorithm>
+
+using namespace geometry;
+
+namespace
+{
+    using stdx::uint;
+
+    aabb combine(aabb l, aabb const& r) { return l += r; }
+
+    // half the surface area, the cost of a node in the insertion heuristic
+    float area(aabb const& b)
+    {
+        auto const d = b.span();
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    bool contains(aabb const& outer, aabb const& inner)
+    {
+        return outer.min_pt.x <= inner.min_pt.x && outer.min_pt.y <= inner.min_pt.y && outer.min_pt.z <= inner.min_pt.z && inner.max_pt.x <= outer.max_pt.x && inner.max_pt.y <= outer.max_pt.y && inner.max_pt.z <= outer.max_pt.z;
+    }
+
+    // slab test, t is the entry distance along dir(0 when origin is inside)
+    bool rayaabb(aabb const& b, vector3 const& origin, vector3 const& invdir, float maxt, float& t)
+    {
+        float tmin = 0.f, tmax = maxt;
+        float const o[3] = { origin.x, origin.y, origin.z }, inv[3] = { invdir.x, invdir.y, invdir.z };
+        float const mn[3] = { b.min_pt.x, b.min_pt.y, b.min_pt.z }, mx[3] = { b.max_pt.x, b.max_pt.y, b.max_pt.z };
+        for (uint i = 0; i < 3; ++i)
+        {
+            float const t0 = (mn[i] - o[i]) * inv[i];
+            float const t1 = (mx[i] - o[i]) * inv[i];
+            tmin = std::max(tmin, std::min(t0, t1));
+            tmax = std::min(tmax, std::max(t0, t1));
+        }
+
+        t = tmin;
+        return tmin <= tmax;
+    }
+
+    // cell coordinates are packed into 21 bits each
+    constexpr uint maxcoord = (1u << 21) - 1;
+}
+
+void collision::paircoloring::build(std::vector<broadphase::proxypair> const& pairs)
+{
+    uint numproxies = 0;
+    for (auto const& [l, r] : pairs)
+        numproxies = std::max(numproxies, std::max(l, r) + 1);
+
+    usedcolors.assign(numproxies, 0);
+    colors.resize(pairs.size());
+
+    uint numcolors = 0;
+    uint overflow = maxcolors;
+    for (uint i = 0; i < pairs.size(); ++i)
+    {
+        auto const [l, r] = pairs[i];
+        uint64_t const freecolors = ~(usedcolors[l] | usedcolors[r]);
+        if (freecolors == 0)
+        {
+            colors[i] = overflow++;
+            numcolors = overflow;
+            continue;
+        }
+
+        uint const c = std::countr_zero(freecolors);
+        usedcolors[l] |= uint64_t(1) << c;
+        usedcolors[r] |= uint64_t(1) << c;
+        colors[i] = c;
+        numcolors = std::max(numcolors, c + 1);
+    }
+
+    // counting sort by color, stable so each color keeps the order of the pairs
+    offsets.assign(numcolors + 1, 0);
+    for (auto const c : colors)
+        offsets[c + 1]++;
+
+    for (uint c = 0; c < numcolors; ++c)
+        offsets[c + 1] += offsets[c];
+
+    order.resize(pairs.size());
+    std::vector<uint> fill(offsets.begin(), offsets.end() - 1);
+    for (uint i = 0; i < pairs.size(); ++i)
+        order[fill[colors[i]]++] = i;
+}
+
+collision::spatial_partition::spatial_partition(float _gridsize, aabb const& _space_bounds) : gridsize(_gridsize), space_bounds(_space_bounds)
 {
+    auto const span = space_bounds.span();
+    float const extents[3] = { span.x, span.y, span.z };
+    for (uint i = 0; i < 3; ++i)
+        maxcell[i] = std::min(static_cast<uint>(std::max(std::floor(extents[i] / gridsize), 0.f)), maxcoord);
+
+    proxies.reserve(storage_size);
+    cells.reserve(storage_size);
+}
+
+stdx::uint collision::spatial_partition::insert(aabb const& box)
+{
+    uint proxyidx;
+    if (freeproxies.empty())
+    {
+        proxyidx = static_cast<uint>(proxies.size());
+        proxies.emplace_back();
+    }
+    else
+    {
+        proxyidx = freeproxies.back();
+        freeproxies.pop_back();
+    }
+
+    proxies[proxyidx] = { box, cellsof(box), true };
+    addtocells(proxyidx);
+    return proxyidx;
+}
+
+void collision::spatial_partition::remove(uint proxyidx)
+{
+    assert(proxies[proxyidx].active);
+    removefromcells(proxyidx);
+    proxies[proxyidx].active = false;
+    freeproxies.push_back(proxyidx);
+}
+
+void collision::spatial_partition::update(uint proxyidx, aabb const& box)
+{
+    auto& p = proxies[proxyidx];
+    assert(p.active);
+
+    p.box = box;
+    auto const range = cellsof(box);
+    if (range == p.range)
+        return;
+
+    removefromcells(proxyidx);
+    p.range = range;
+    addtocells(proxyidx);
+}
+
+std::vector<collision::spatial_partition::proxypair> const& collision::spatial_partition::findpairs()
+{
+    pairs.clear();
+    for (auto const& [cellkey, c] : cells)
+    {
+        auto const& cellproxies = c.proxies;
+        for (uint i = 0; i < cellproxies.size(); ++i)
+            for (uint j = i + 1; j < cellproxies.size(); ++j)
+            {
+                auto const& l = proxies[cellproxies[i]];
+                auto const& r = proxies[cellproxies[j]];
+
+                // a pair sharing several cells is reported only by the first cell of the overlap
+                stdx::vecui3 const first = { std::max(l.range.min[0], r.range.min[0]), std::max(l.range.min[1], r.range.min[1]), std::max(l.range.min[2], r.range.min[2]) };
+                if (first != c.coords || !l.box.overlap(r.box))
+                    continue;
+
+                pairs.emplace_back(std::min(cellproxies[i], cellproxies[j]), std::max(cellproxies[i], cellproxies[j]));
+            }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
 }
+
+collision::spatial_partition::cellrange collision::spatial_partition::cellsof(aabb const& box) const
+{
+    auto const tocell = [this](float v, float origin, uint axis)
+    {
+        float const c = std::floor((v - origin) / gridsize);
+        return c <= 0.f ? 0u : std::min(static_cast<uint>(c), maxcell[axis]);
+    };
+
+    cellrange r;
+    r.min = { tocell(box.min_pt.x, space_bounds.min_pt.x, 0), tocell(box.min_pt.y, space_bounds.min_pt.y, 1), tocell(box.min_pt.z, space_bounds.min_pt.z, 2) };
+    r.max = { tocell(box.max_pt.x, space_bounds.min_pt.x, 0), tocell(box.max_pt.y, space_bounds.min_pt.y, 1), tocell(box.max_pt.z, space_bounds.min_pt.z, 2) };
+    return r;
+}
+
+uint64_t collision::spatial_partition::key(stdx::vecui3 const& coords)
+{
+    return uint64_t(coords[0]) | (uint64_t(coords[1]) << 21) | (uint64_t(coords[2]) << 42);
+}
+
+void collision::spatial_partition::addtocells(uint proxyidx)
+{
+    auto const& range = proxies[proxyidx].range;
+    for (uint z = range.min[2]; z <= range.max[2]; ++z)
+        for (uint y = range.min[1]; y <= range.max[1]; ++y)
+            for (uint x = range.min[0]; x <= range.max[0]; ++x)
+            {
+                stdx::vecui3 const coords = { x, y, z };
+                auto& c = cells[key(coords)];
+                c.coords = coords;
+                c.proxies.push_back(proxyidx);
+            }
+}
+
+void collision::spatial_partition::removefromcells(uint proxyidx)
+{
+    // emptied cells are kept, there are at most as many as fit in space_bounds and their storage gets reused
+    auto const& range = proxies[proxyidx].range;
+    for (uint z = range.min[2]; z <= range.max[2]; ++z)
+        for (uint y = range.min[1]; y <= range.max[1]; ++y)
+            for (uint x = range.min[0]; x <= range.max[0]; ++x)
+            {
+                auto& cellproxies = cells[key({ x, y, z })].proxies;
+                auto const found = std::find(cellproxies.begin(), cellproxies.end(), proxyidx);
+                assert(found != cellproxies.end());
+
+                *found = cellproxies.back();
+                cellproxies.pop_back();
+            }
+}
+
+stdx::uint collision::sweep_and_prune::insert(aabb const& box)
+{
+    uint proxyidx;
+    if (freeproxies.empty())
+    {
+        proxyidx = static_cast<uint>(proxies.size());
+        proxies.emplace_back();
+    }
+    else
+    {
+        proxyidx = freeproxies.back();
+        freeproxies.pop_back();
+    }
+
+    proxies[proxyidx] = { box, true };
+
+    // new endpoints go at the end, the next findpairs sorts them into place
+    endpoints.push_back({ 0.f, proxyidx, false });
+    endpoints.push_back({ 0.f, proxyidx, true });
+    return proxyidx;
+}
+
+void collision::sweep_and_prune::remove(uint proxyidx)
+{
+    assert(proxies[proxyidx].active);
+    std::erase_if(endpoints, [proxyidx](endpoint const& e) { return e.proxy == proxyidx; });
+    proxies[proxyidx].active = false;
+    freeproxies.push_back(proxyidx);
+}
+
+void collision::sweep_and_prune::update(uint proxyidx, aabb const& box)
+{
+    assert(proxies[proxyidx].active);
+    proxies[proxyidx].box = box;
+}
+
+std::vector<collision::sweep_and_prune::proxypair> const& collision::sweep_and_prune::findpairs()
+{
+    for (auto& e : endpoints)
+        e.value = endvalue(e);
+
+    // insertion sort, the endpoints are nearly sorted from the previous frame
+    swaps = 0;
+    for (uint i = 1; i < endpoints.size(); ++i)
+    {
+        auto const e = endpoints[i];
+        uint j = i;
+        for (; j > 0 && e < endpoints[j - 1]; --j)
+            endpoints[j] = endpoints[j - 1];
+
+        endpoints[j] = e;
+        swaps += i - j;
+    }
+
+    // boxes overlapping along the axis are the ones still open when a box starts, a new box is tested against all of them at once
+    pairs.clear();
+    activeproxies.clear();
+    activeboxes.resize(0);
+    for (auto const& e : endpoints)
+    {
+        if (e.ismax)
+        {
+            auto const found = std::find(activeproxies.begin(), activeproxies.end(), e.proxy);
+            activeboxes.removeswap(static_cast<uint>(found - activeproxies.begin()));
+            *found = activeproxies.back();
+            activeproxies.pop_back();
+            continue;
+        }
+
+        auto const& box = proxies[e.proxy].box;
+        activeboxes.overlaps(box, hits);
+        for (auto const hit : hits)
+        {
+            uint const other = activeproxies[hit];
+            pairs.emplace_back(std::min(e.proxy, other), std::max(e.proxy, other));
+        }
+
+        activeproxies.push_back(e.proxy);
+        activeboxes.push_back(box);
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+float collision::sweep_and_prune::endvalue(endpoint const& e) const
+{
+    auto const& box = proxies[e.proxy].box;
+    auto const& pt = e.ismax ? box.max_pt : box.min_pt;
+    return axis == 0 ? pt.x : (axis == 1 ? pt.y : pt.z);
+}
+
+stdx::uint collision::aabbtree::insert(aabb const& box)
+{
+    uint proxyidx;
+    if (freeproxies.empty())
+    {
+        proxyidx = static_cast<uint>(proxies.size());
+        proxies.emplace_back();
+    }
+    else
+    {
+        proxyidx = freeproxies.back();
+        freeproxies.pop_back();
+    }
+
+    uint const leaf = allocatenode();
+    nodes[leaf].box = fatten(box);
+    nodes[leaf].proxy = proxyidx;
+    proxies[proxyidx] = { box, leaf, true };
+
+    insertleaf(leaf);
+    return proxyidx;
+}
+
+void collision::aabbtree::remove(uint proxyidx)
+{
+    auto& p = proxies[proxyidx];
+    assert(p.active);
+
+    removeleaf(p.leaf);
+    freenode(p.leaf);
+    p = {};
+    freeproxies.push_back(proxyidx);
+}
+
+void collision::aabbtree::update(uint proxyidx, aabb const& box)
+{
+    auto& p = proxies[proxyidx];
+    assert(p.active);
+
+    p.box = box;
+    if (contains(nodes[p.leaf].box, box))
+        return;
+
+    ++reinserts;
+    removeleaf(p.leaf);
+    nodes[p.leaf].box = fatten(box);
+    insertleaf(p.leaf);
+}
+
+std::vector<collision::aabbtree::proxypair> const& collision::aabbtree::findpairs()
+{
+    lastreinserts = std::exchange(reinserts, 0);
+    pairs.clear();
+    if (root == nullnode)
+        return pairs;
+
+    // descend the tree against itself, so subtrees that do not overlap are rejected once instead of once per leaf
+    pairstack.clear();
+    pairstack.emplace_back(root, root);
+    while (!pairstack.empty())
+    {
+        auto const [lidx, ridx] = pairstack.back();
+        pairstack.pop_back();
+
+        auto const& l = nodes[lidx];
+        auto const& r = nodes[ridx];
+        if (lidx == ridx)
+        {
+            if (!l.isleaf())
+            {
+                pairstack.emplace_back(l.left, l.left);
+                pairstack.emplace_back(l.right, l.right);
+                pairstack.emplace_back(l.left, l.right);
+            }
+
+            continue;
+        }
+
+        if (!l.box.overlap(r.box))
+            continue;
+
+        if (l.isleaf() && r.isleaf())
+        {
+            // the tree only knows fat boxes, the proxies' own boxes decide
+            if (proxies[l.proxy].box.overlap(proxies[r.proxy].box))
+                pairs.emplace_back(std::min(l.proxy, r.proxy), std::max(l.proxy, r.proxy));
+
+            continue;
+        }
+
+        // split the bigger node
+        if (r.isleaf() || (!l.isleaf() && area(l.box) >= area(r.box)))
+        {
+            pairstack.emplace_back(l.left, ridx);
+            pairstack.emplace_back(l.right, ridx);
+        }
+        else
+        {
+            pairstack.emplace_back(lidx, r.left);
+            pairstack.emplace_back(lidx, r.right);
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+std::optional<collision::aabbtree::rayhit> collision::aabbtree::raycast(vector3 const& origin, vector3 const& dir, float maxt) const
+{
+    if (root == nullnode)
+        return {};
+
+    vector3 const invdir = { 1.f / dir.x, 1.f / dir.y, 1.f / dir.z };
+    std::optional<rayhit> closest;
+
+    std::array<uint, maxdepth> stack;
+    uint top = 0;
+    stack[top++] = root;
+    while (top > 0)
+    {
+        auto const& n = nodes[stack[--top]];
+
+        // nodes starting past the closest hit so far cannot hold a closer one
+        float t;
+        if (!rayaabb(n.box, origin, invdir, maxt, t))
+            continue;
+
+        if (n.isleaf())
+        {
+            if (rayaabb(proxies[n.proxy].box, origin, invdir, maxt, t))
+            {
+                closest = rayhit{ n.proxy, t };
+                maxt = t;
+            }
+
+            continue;
+        }
+
+        assert(top + 2 <= maxdepth);
+        stack[top++] = n.left;
+        stack[top++] = n.right;
+    }
+
+    return closest;
+}
+
+stdx::uint collision::aabbtree::allocatenode()
+{
+    if (freenodes.empty())
+    {
+        nodes.emplace_back();
+        return static_cast<uint>(nodes.size() - 1);
+    }
+
+    uint const nodeidx = freenodes.back();
+    freenodes.pop_back();
+    nodes[nodeidx] = {};
+    return nodeidx;
+}
+
+void collision::aabbtree::freenode(uint nodeidx)
+{
+    nodes[nodeidx].height = -1;
+    freenodes.push_back(nodeidx);
+}
+
+void collision::aabbtree::insertleaf(uint leaf)
+{
+    if (root == nullnode)
+    {
+        root = leaf;
+        nodes[root].parent = nullnode;
+        return;
+    }
+
+    // descend to the sibling that grows the tree's total area the least
+    auto const leafbox = nodes[leaf].box;
+    uint sibling = root;
+    while (!nodes[sibling].isleaf())
+    {
+        auto const& n = nodes[sibling];
+        float const combinedarea = area(combine(n.box, leafbox));
+
+        // cost of pairing with this node, and the growth its ancestors of a deeper pairing pay
+        float const cost = 2.f * combinedarea;
+        float const inheritance = 2.f * (combinedarea - area(n.box));
+
+        auto const descendcost = [&](uint child)
+        {
+            auto const& c = nodes[child];
+            float const grown = area(combine(leafbox, c.box));
+            return (c.isleaf() ? grown : grown - area(c.box)) + inheritance;
+        };
+
+        float const costleft = descendcost(n.left);
+        float const costright = descendcost(n.right);
+        if (cost < costleft && cost < costright)
+            break;
+
+        sibling = costleft < costright ? n.left : n.right;
+    }
+
+    uint const oldparent = nodes[sibling].parent;
+    uint const newparent = allocatenode();
+    nodes[newparent].parent = oldparent;
+    nodes[newparent].box = combine(leafbox, nodes[sibling].box);
+    nodes[newparent].height = nodes[sibling].height + 1;
+    nodes[newparent].left = sibling;
+    nodes[newparent].right = leaf;
+    nodes[sibling].parent = newparent;
+    nodes[leaf].parent = newparent;
+
+    if (oldparent == nullnode)
+        root = newparent;
+    else if (nodes[oldparent].left == sibling)
+        nodes[oldparent].left = newparent;
+    else
+        nodes[oldparent].right = newparent;
+
+    refit(newparent);
+}
+
+void collision::aabbtree::removeleaf(uint leaf)
+{
+    if (leaf == root)
+    {
+        root = nullnode;
+        return;
+    }
+
+    uint const parent = nodes[leaf].parent;
+    uint const grandparent = nodes[parent].parent;
+    uint const sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    // the sibling takes the parent's place
+    nodes[sibling].parent = grandparent;
+    freenode(parent);
+    if (grandparent == nullnode)
+    {
+        root = sibling;
+        return;
+    }
+
+    if (nodes[grandparent].left == parent)
+        nodes[grandparent].left = sibling;
+    else
+        nodes[grandparent].right = sibling;
+
+    refit(grandparent);
+}
+
+void collision::aabbtree::refit(uint nodeidx)
+{
+    // rebalance and recompute the boxes and heights from nodeidx up to the root
+    while (nodeidx != nullnode)
+    {
+        nodeidx = balance(nodeidx);
+
+        auto& n = nodes[nodeidx];
+        n.height = 1 + std::max(nodes[n.left].height, nodes[n.right].height);
+        n.box = combine(nodes[n.left].box, nodes[n.right].box);
+        nodeidx = n.parent;
+    }
+}
+
+stdx::uint collision::aabbtree::balance(uint aidx)
+{
+    auto& a = nodes[aidx];
+    if (a.isleaf() || a.height < 2)
+        return aidx;
+
+    uint const bidx = a.left, cidx = a.right;
+    auto& b = nodes[bidx];
+    auto& c = nodes[cidx];
+    int const imbalance = c.height - b.height;
+    if (imbalance >= -1 && imbalance <= 1)
+        return aidx;
+
+    // the taller child(up) replaces a, a keeps its shorter child and the shorter grandchild below up
+    uint const upidx = imbalance > 1 ? cidx : bidx;
+    uint const otheridx = imbalance > 1 ? bidx : cidx;
+    auto& up = nodes[upidx];
+
+    uint const fidx = up.left, gidx = up.right;
+    up.left = aidx;
+    up.parent = a.parent;
+    a.parent = upidx;
+
+    if (up.parent == nullnode)
+        root = upidx;
+    else if (nodes[up.parent].left == aidx)
+        nodes[up.parent].left = upidx;
+    else
+        nodes[up.parent].right = upidx;
+
+    uint const tallidx = nodes[fidx].height > nodes[gidx].height ? fidx : gidx;
+    uint const shortidx = tallidx == fidx ? gidx : fidx;
+
+    up.right = tallidx;
+    if (imbalance > 1)
+        a.right = shortidx;
+    else
+        a.left = shortidx;
+
+    nodes[shortidx].parent = aidx;
+
+    a.box = combine(nodes[otheridx].box, nodes[shortidx].box);
+    a.height = 1 + std::max(nodes[otheridx].height, nodes[shortidx].height);
+    up.box = combine(a.box, nodes[tallidx].box);
+    up.height = 1 + std::max(a.height, nodes[tallidx].height);
+
+    return upidx;
+}
+
+aabb collision::aabbtree::fatten(aabb const& box) const { return { box.min_pt - vector3{ margin }, box.max_pt + vector3{ margin } }; }
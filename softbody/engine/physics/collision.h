@@ -1,26 +1,307 @@
 #pragma once
 
-#include "Engine/SimpleMath.h"
+#include "engine/simplemath.h"
 #include "DirectXMath.h"
-#include "Engine/engineutils.h"
+#include "engine/engineutils.h"
 #include "engine/core.h"
 #include "engine/geometry/geocore.h"
+#include "stdx/vec.h"
 
+#include <array>
+#include <algorithm>
+#include <span>
 #include <vector>
+#include <limits>
+#include <utility>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
 
 namespace collision
 {
-    class spatial_partition
+    using stdx::uint;
+
+    // pair generation shared by the broadphases, bodies are proxies identified by the index returned from insert
+    class broadphase
+    {
+    public:
+        using proxypair = std::pair<uint, uint>;
+
+        virtual ~broadphase() = default;
+
+        virtual uint insert(geometry::aabb const& box) = 0;
+        virtual void remove(uint proxy) = 0;
+        virtual void update(uint proxy, geometry::aabb const& box) = 0;
+
+        // pairs of proxies whose boxes overlap, smaller proxy first, sorted so the order does not depend on the broadphase
+        virtual std::vector<proxypair> const& findpairs() = 0;
+
+        // pairs found by the last findpairs
+        uint numpairs() const { return static_cast<uint>(pairs.size()); }
+
+    protected:
+        std::vector<proxypair> pairs;
+    };
+
+    // state kept per pair of proxies across frames, e.g. the contacts of the pair
+    // pairs not touched since the last endframe are dropped by it, so the cache follows the pairs of the broadphase
+    template<typename t>
+    class paircache
+    {
+    public:
+        // the state of the pair and whether it was created by this call
+        std::pair<t&, bool> touch(broadphase::proxypair const& pair)
+        {
+            auto const [found, inserted] = entries.try_emplace(key(pair));
+            found->second.frame = frame;
+            return { found->second.value, inserted };
+        }
+
+        void endframe()
+        {
+            std::erase_if(entries, [this](auto const& e) { return e.second.frame != frame; });
+            frame++;
+        }
+
+        void clear() { entries.clear(); }
+        uint size() const { return static_cast<uint>(entries.size()); }
+
+    private:
+        struct entry
+        {
+            t value = {};
+            uint frame = 0;
+        };
+
+        static uint64_t key(broadphase::proxypair const& pair) { return (uint64_t(std::min(pair.first, pair.second)) << 32) | uint64_t(std::max(pair.first, pair.second)); }
+
+        uint frame = 0;
+        std::unordered_map<uint64_t, entry> entries;
+    };
+
+    // the contact graph of the pairs colored so that no proxy is in two pairs of the same color
+    // pairs of one color touch different bodies, so they can be resolved at the same time and in any order
+    // colors are assigned greedily in the order of the pairs, so they only depend on the pairs and not on who resolves them
+    class paircoloring
+    {
+    public:
+        void build(std::vector<broadphase::proxypair> const& pairs);
+
+        uint numcolors() const { return offsets.empty() ? 0 : static_cast<uint>(offsets.size()) - 1; }
+
+        // indices into the pairs of color c, in increasing order
+        std::span<uint const> color(uint c) const { return { order.data() + offsets[c], order.data() + offsets[c + 1] }; }
+
+    private:
+        // colors tracked per proxy, a pair that finds all of them taken gets a color of its own
+        static constexpr uint maxcolors = 64;
+
+        std::vector<uint64_t> usedcolors;
+        std::vector<uint> colors;
+        std::vector<uint> order;
+        std::vector<uint> offsets;
+    };
+
+    // uniform grid of gridsize cells, only the occupied cells are stored(hashed on their coordinates)
+    // boxes outside space_bounds are clamped to the border cells
+    class spatial_partition : public broadphase
     {
     public:
         spatial_partition() = default;
-        spatial_partition(float _gridsize, geometry::aabb const& _space_bounds) : gridsize(_gridsize), space_bounds(_space_bounds) {}
-        void update(std::vector<vector3> const &tris, float dt);
+        spatial_partition(float _gridsize, geometry::aabb const& _space_bounds);
+
+        uint insert(geometry::aabb const& box) override;
+        void remove(uint proxy) override;
+
+        // moves the proxy to the cells box overlaps, cheap when the cells did not change
+        void update(uint proxy, geometry::aabb const& box) override;
+        std::vector<proxypair> const& findpairs() override;
+
+        uint numcells() const { return static_cast<uint>(cells.size()); }
 
     private:
+        struct cellrange
+        {
+            stdx::vecui3 min = {}, max = {};
+            bool operator==(cellrange const&) const = default;
+        };
+
+        struct proxy
+        {
+            geometry::aabb box;
+            cellrange range;
+            bool active = false;
+        };
+
+        struct cell
+        {
+            stdx::vecui3 coords;
+            std::vector<uint> proxies;
+        };
+
+        cellrange cellsof(geometry::aabb const& box) const;
+        static uint64_t key(stdx::vecui3 const& coords);
+        void addtocells(uint proxyidx);
+        void removefromcells(uint proxyidx);
+
         float gridsize = 1.f;
         geometry::aabb space_bounds;
+        stdx::vecui3 maxcell = {};
+
+        std::vector<proxy> proxies;
+        std::vector<uint> freeproxies;
+        std::unordered_map<uint64_t, cell> cells;
 
         static constexpr std::size_t storage_size = 256;
     };
-}
\ No newline at end of file
+
+    // sort and sweep along one axis, the endpoints stay sorted from the previous frame
+    // so an insertion sort fixes them up in close to linear time when bodies move little per step
+    class sweep_and_prune : public broadphase
+    {
+    public:
+        sweep_and_prune(uint _axis = 0) : axis(_axis) {}
+
+        uint insert(geometry::aabb const& box) override;
+        void remove(uint proxy) override;
+        void update(uint proxy, geometry::aabb const& box) override;
+        std::vector<proxypair> const& findpairs() override;
+
+        // endpoint swaps of the last findpairs, low when the scene is coherent
+        uint numswaps() const { return swaps; }
+
+    private:
+        struct proxy
+        {
+            geometry::aabb box;
+            bool active = false;
+        };
+
+        // ismax sorts after a min with the same value, so touching boxes are reported like the other broadphases do
+        struct endpoint
+        {
+            float value;
+            uint proxy;
+            bool ismax;
+
+            bool operator<(endpoint const& r) const { return value < r.value || (value == r.value && ismax < r.ismax); }
+        };
+
+        float endvalue(endpoint const& e) const;
+
+        uint axis = 0;
+        uint swaps = 0;
+        std::vector<proxy> proxies;
+        std::vector<uint> freeproxies;
+        std::vector<endpoint> endpoints;
+
+        // open boxes while sweeping, activeboxes has the boxes of activeproxies in the same order
+        std::vector<uint> activeproxies;
+        geometry::aabbsoa activeboxes;
+        std::vector<uint> hits;
+    };
+
+    // dynamic bounding volume tree, for bodies of mixed sizes
+    // leaves hold boxes fattened by margin so bodies moving a little keep their leaf, internal nodes are kept balanced by rotations
+    // besides pairs it answers box and ray queries, e.g. static geometry around a body or a pick along cursor::ray
+    class aabbtree : public broadphase
+    {
+    public:
+        struct rayhit
+        {
+            uint proxy;
+            float t;
+        };
+
+        aabbtree(float _margin = 0.1f) : margin(_margin) {}
+
+        uint insert(geometry::aabb const& box) override;
+        void remove(uint proxy) override;
+
+        // reinserts the leaf only when box left its fat box
+        void update(uint proxy, geometry::aabb const& box) override;
+        std::vector<proxypair> const& findpairs() override;
+
+        // visits the proxies whose fat boxes overlap box
+        template<typename visitor_t>
+        void query(geometry::aabb const& box, visitor_t&& visit) const;
+
+        // closest proxy whose box dir hits within maxt of origin, dir need not be normalized(t is in units of dir)
+        std::optional<rayhit> raycast(vector3 const& origin, vector3 const& dir, float maxt = std::numeric_limits<float>::max()) const;
+
+        uint height() const { return root == nullnode ? 0 : static_cast<uint>(nodes[root].height); }
+
+        // leaves the updates before the last findpairs had to reinsert, low when the margin suits the motion
+        uint numreinserts() const { return lastreinserts; }
+
+    private:
+        static constexpr uint nullnode = std::numeric_limits<uint>::max();
+
+        // the stack of a traversal, a balanced tree is nowhere near this deep
+        static constexpr uint maxdepth = 128;
+
+        struct node
+        {
+            geometry::aabb box;
+            uint parent = nullnode;
+            uint left = nullnode;
+            uint right = nullnode;
+            int height = 0;
+            uint proxy = 0;
+
+            bool isleaf() const { return left == nullnode; }
+        };
+
+        struct proxy
+        {
+            geometry::aabb box;
+            uint leaf = nullnode;
+            bool active = false;
+        };
+
+        uint allocatenode();
+        void freenode(uint nodeidx);
+        void insertleaf(uint leaf);
+        void removeleaf(uint leaf);
+        void refit(uint nodeidx);
+        uint balance(uint nodeidx);
+        geometry::aabb fatten(geometry::aabb const& box) const;
+
+        float margin = 0.1f;
+        uint root = nullnode;
+        uint reinserts = 0;
+        uint lastreinserts = 0;
+        std::vector<node> nodes;
+        std::vector<uint> freenodes;
+        std::vector<proxy> proxies;
+        std::vector<uint> freeproxies;
+        std::vector<std::pair<uint, uint>> pairstack;
+    };
+
+    template<typename visitor_t>
+    void aabbtree::query(geometry::aabb const& box, visitor_t&& visit) const
+    {
+        if (root == nullnode)
+            return;
+
+        std::array<uint, maxdepth> stack;
+        uint top = 0;
+        stack[top++] = root;
+        while (top > 0)
+        {
+            auto const& n = nodes[stack[--top]];
+            if (!n.box.overlap(box))
+                continue;
+
+            if (n.isleaf())
+            {
+                visit(n.proxy);
+                continue;
+            }
+
+            assert(top + 2 <= maxdepth);
+            stack[top++] = n.left;
+            stack[top++] = n.right;
+        }
+    }
+}
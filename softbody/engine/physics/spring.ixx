@@ -1,7 +1,8 @@
 module;
 
 #include "engine/core.h"
-#include <cmath> 
+#include "engine/physics/springkernels.h"
+#include <cmath>
 
 export module spring;
 
@@ -14,28 +15,40 @@ struct spring
 
     std::pair<vector3, vector3> damped(vector3 const& displacement, vector3 const& vel, float dt) const
     {
-        std::pair<vector3, vector3> res;
-
-        res.first = std::powf(2.71828f, -omega * eta * dt) * (displacement * std::cos(alpha * dt) + (vel + omega * eta * displacement) * std::sin(alpha * dt) / alpha);
-        res.second = -std::pow(2.71828f, -omega * eta * dt) * ((displacement * omega * eta - vel - omega * eta * displacement) * cos(alpha * dt) +
-                    (displacement * alpha + (vel+ omega * eta * displacement) * omega * eta / alpha) * sin(alpha * dt));
-        return res;
+        auto const t = transition(dt);
+        return { displacement * t.dd + vel * t.dv, displacement * t.vd + vel * t.vv };
     }
 
     std::pair<vector3, vector3> critical(vector3 const& displacement, vector3 const& vel, float dt) const
     {
         std::pair<vector3, vector3> res;
 
-        res.first = ((vel + displacement * omega) * dt + displacement) * std::powf(2.71828f, -omega * dt);
-        res.second = (vel - (vel + displacement * omega) * omega * dt) * std::powf(2.71828f, -omega * dt);
+        res.first = ((vel + displacement * omega()) * dt + displacement) * std::pow(2.71828f, -omega() * dt);
+        res.second = (vel - (vel + displacement * omega()) * omega() * dt) * std::pow(2.71828f, -omega() * dt);
         return res;
     }
 
-    // eta = damping factor
+    // the damped solution over dt as coefficients of the state, it only depends on dt and the constants so it can be computed once for any number of points
+    // damping of 1 or more is treated as critical
+    springkernels::transition transition(float dt) const
+    {
+        if (eta >= 1.f)
+        {
+            float const decay = std::pow(2.71828f, -omega() * dt);
+            return { (1.f + omega() * dt) * decay, dt * decay, -omega() * omega() * dt * decay, (1.f - omega() * dt) * decay };
+        }
+
+        float const decay = std::pow(2.71828f, -omega() * eta * dt);
+        float const alpha = omega() * std::sqrt(1 - eta * eta);
+        float const c = std::cos(alpha * dt), s = std::sin(alpha * dt) / alpha;
+        return { (c + omega() * eta * s) * decay, s * decay, -omega() * omega() * s * decay, (c - omega() * eta * s) * decay };
+    }
+
     // omega = std::sqrt(spring_const / mass);
-    static constexpr float eta = 0.5f;
-    static constexpr float springconst = 7.29f;
-    float const omega = std::sqrt(springconst / 1.f);
-    float const alpha = omega * std::sqrt(1 - eta * eta);
+    float omega() const { return std::sqrt(springconst / 1.f); }
+
+    // eta = damping factor
+    float eta = 0.5f;
+    float springconst = 7.29f;
 };
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "springkernels.h"
+
+// portable fallback, softbody_bench_beziermaths compares the avx2 kernel to it
+namespace
+{
+using stdx::uint;
+
+using namespace physx::springkernels;
+
+void step(float* points, float const* rest, float* velocities, uint count, transition const& t)
+{
+    for (uint i = 0; i < count; ++i)
+    {
+        float const displacement = points[i] - rest[i];
+        points[i] = rest[i] + t.dd * displacement + t.dv * velocities[i];
+        velocities[i] = t.vd * displacement + t.vv * velocities[i];
+    }
+}
+}
+
+namespace physx::springkernels
+{
+table const& scalar()
+{
+    static table const t{ simd::isa::scalar, step };
+    return t;
+}
+
+table const& active()
+{
+    static table const& t = simd::active() >= simd::isa::avx2 ? avx2() : scalar();
+    return t;
+}
+}
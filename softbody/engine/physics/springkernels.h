@@ -0,0 +1,39 @@
+#pragma once
+
+#include "stdx/stdxcore.h"
+#include "engine/simd.h"
+
+// raw kernels behind the control point springs, one table per instruction set
+namespace physx::springkernels
+{
+using stdx::uint;
+
+// floats per register of the widest table
+inline constexpr uint width = 8;
+
+// a damped spring over a step of fixed length is a linear map of its state
+// new displacement = dd * displacement + dv * velocity, new velocity = vd * displacement + vv * velocity
+struct transition
+{
+    float dd = 1.f, dv = 0.f;
+    float vd = 0.f, vv = 1.f;
+
+    bool operator==(transition const&) const = default;
+};
+
+// steps count floats of points towards rest, velocities are updated in place
+// the floats are independent, so xyz of the points can be interleaved
+using step_fn = void(*)(float* points, float const* rest, float* velocities, uint count, transition const& t);
+
+struct table
+{
+    simd::isa isa;
+    step_fn step;
+};
+
+table const& scalar();
+table const& avx2();
+
+// table for simd::active()
+table const& active();
+}
@@ -0,0 +1,47 @@
+#include "springkernels.h"
+
+#include <immintrin.h>
+
+// 8 floats per register, this file is built with /arch:AVX2
+namespace
+{
+using stdx::uint;
+
+using namespace physx::springkernels;
+
+// lanes below n set, for the last partial register of a range
+__m256i lanemask(uint n) { return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(n)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+
+__m256 load(float const* src, uint n) { return n == width ? _mm256_loadu_ps(src) : _mm256_maskload_ps(src, lanemask(n)); }
+
+void store(float* dst, __m256 v, uint n)
+{
+    if (n == width) _mm256_storeu_ps(dst, v);
+    else _mm256_maskstore_ps(dst, lanemask(n), v);
+}
+
+void step(float* points, float const* rest, float* velocities, uint count, transition const& t)
+{
+    __m256 const dd = _mm256_set1_ps(t.dd), dv = _mm256_set1_ps(t.dv);
+    __m256 const vd = _mm256_set1_ps(t.vd), vv = _mm256_set1_ps(t.vv);
+    for (uint i = 0; i < count; i += width)
+    {
+        uint const n = count - i < width ? count - i : width;
+
+        __m256 const r = load(rest + i, n);
+        __m256 const v = load(velocities + i, n);
+        __m256 const displacement = _mm256_sub_ps(load(points + i, n), r);
+        store(points + i, _mm256_add_ps(r, _mm256_fmadd_ps(dd, displacement, _mm256_mul_ps(dv, v))), n);
+        store(velocities + i, _mm256_fmadd_ps(vd, displacement, _mm256_mul_ps(vv, v)), n);
+    }
+}
+}
+
+namespace physx::springkernels
+{
+table const& avx2()
+{
+    static table const t{ simd::isa::avx2, step };
+    return t;
+}
+}
@@ -0,0 +1,114 @@
+#include "simd.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace
+{
+struct cpuidregs
+{
+    uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+};
+
+cpuidregs cpuid(uint32_t leaf, uint32_t subleaf = 0)
+{
+    cpuidregs r;
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+    r = { static_cast<uint32_t>(regs[0]), static_cast<uint32_t>(regs[1]), static_cast<uint32_t>(regs[2]), static_cast<uint32_t>(regs[3]) };
+#else
+    __cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+#endif
+    return r;
+}
+
+// register state the os saves on context switches
+uint64_t xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+}
+
+bool bit(uint32_t reg, uint32_t b) { return (reg >> b) & 1u; }
+}
+
+namespace simd
+{
+isa detect()
+{
+    uint32_t const maxleaf = cpuid(0).eax;
+    if (maxleaf < 1)
+        return isa::scalar;
+
+    auto const leaf1 = cpuid(1);
+    if (!bit(leaf1.ecx, 19) || !bit(leaf1.ecx, 20))
+        return isa::scalar;
+
+    // avx needs os support for the ymm state, fma is required by the avx2 kernels
+    bool const osxsave = bit(leaf1.ecx, 27);
+    if (!osxsave || !bit(leaf1.ecx, 28) || !bit(leaf1.ecx, 12) || maxleaf < 7)
+        return isa::sse4;
+
+    uint64_t const xcr0 = xgetbv0();
+    auto const leaf7 = cpuid(7);
+    if ((xcr0 & 0x6) != 0x6 || !bit(leaf7.ebx, 5))
+        return isa::sse4;
+
+    // the avx512 kernel is built with /arch:AVX512, which emits f, cd, bw, dq and vl instructions
+    // all of them need the opmask and upper zmm state enabled by the os
+    bool const avx512 = bit(leaf7.ebx, 16) && bit(leaf7.ebx, 17) && bit(leaf7.ebx, 28) && bit(leaf7.ebx, 30) && bit(leaf7.ebx, 31);
+    if ((xcr0 & 0xe6) != 0xe6 || !avx512)
+        return isa::avx2;
+
+    return isa::avx512;
+}
+
+isa active()
+{
+    static isa const selected = []
+    {
+        isa const best = detect();
+        char const* requested = std::getenv("SOFTBODY_ISA");
+        if (!requested)
+            return best;
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(isa::num); ++i)
+        {
+            if (std::strcmp(requested, name(static_cast<isa>(i))) != 0)
+                continue;
+
+            if (static_cast<isa>(i) <= best)
+                return static_cast<isa>(i);
+
+            std::fprintf(stderr, "SOFTBODY_ISA=%s is not supported on this machine, using %s\n", requested, name(best));
+            return best;
+        }
+
+        std::fprintf(stderr, "unknown SOFTBODY_ISA=%s, using %s\n", requested, name(best));
+        return best;
+    }();
+
+    return selected;
+}
+
+char const* name(isa i)
+{
+    static char const* names[] = { "scalar", "sse4", "avx2", "avx512" };
+    return i < isa::num ? names[static_cast<uint32_t>(i)] : "unknown";
+}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// the hot kernels come as one table of function pointers per instruction set, active() picks the table they call through
+// kernels only see floats, so the translation units built for wider instruction sets share no inline code with the rest of the build
+// a kernel without a table for the active instruction set uses its next narrower one
+namespace simd
+{
+// instruction sets the hot kernels are built for, in increasing order
+enum class isa
+{
+    scalar,
+    sse4,
+    avx2,
+    avx512,
+    num
+};
+
+// best instruction set supported by both the cpu and the os
+isa detect();
+
+// detect(), unless the SOFTBODY_ISA environment variable(scalar, sse4, avx2 or avx512) asks for another supported one
+// evaluated once, so the override has to be set before the first kernel runs
+isa active();
+
+char const* name(isa i);
+}
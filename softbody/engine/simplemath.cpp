@@ -8,7 +8,7 @@
 // http://go.microsoft.com/fwlink/?LinkID=615561
 //-------------------------------------------------------------------------------------
 
-#include "SimpleMath.h"
+#include "simplemath.h"
 
 /****************************************************************************
  *
@@ -80,6 +80,7 @@ static_assert(offsetof(DirectX::SimpleMath::Viewport, minDepth) == offsetof(D3D1
 static_assert(offsetof(DirectX::SimpleMath::Viewport, maxDepth) == offsetof(D3D12_VIEWPORT, MaxDepth), "Layout mismatch");
 #endif
 
+#ifdef _WIN32
 RECT DirectX::SimpleMath::Viewport::ComputeDisplayArea(DXGI_SCALING scaling, UINT backBufferWidth, UINT backBufferHeight, int outputWidth, int outputHeight) noexcept
 {
     RECT rct = {};
@@ -153,3 +154,4 @@ RECT DirectX::SimpleMath::Viewport::ComputeTitleSafeArea(UINT backBufferWidth, U
 
     return rct;
 }
+#endif
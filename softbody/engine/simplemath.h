@@ -10,7 +10,8 @@
 
 #pragma once
 #define NOMINMAX
-#if !defined(_XBOX_ONE) || !defined(_TITLE)
+// dxgi and the win32 RECT interop are only available on windows, the rest only needs directxmath
+#if defined(_WIN32) && (!defined(_XBOX_ONE) || !defined(_TITLE))
 #include <dxgi1_2.h>
 #endif
 
@@ -51,7 +52,9 @@ namespace DirectX
             // Creators
             Rectangle() noexcept : x(0), y(0), width(0), height(0) {}
             constexpr Rectangle(long ix, long iy, long iw, long ih) noexcept : x(ix), y(iy), width(iw), height(ih) {}
+        #ifdef _WIN32
             explicit Rectangle(const RECT& rct) noexcept : x(rct.left), y(rct.top), width(rct.right - rct.left), height(rct.bottom - rct.top) {}
+        #endif
 
             Rectangle(const Rectangle&) = default;
             Rectangle& operator=(const Rectangle&) = default;
@@ -59,20 +62,24 @@ namespace DirectX
             Rectangle(Rectangle&&) = default;
             Rectangle& operator=(Rectangle&&) = default;
 
+        #ifdef _WIN32
             operator RECT() noexcept { RECT rct; rct.left = x; rct.top = y; rct.right = (x + width); rct.bottom = (y + height); return rct; }
+        #endif
         #ifdef __cplusplus_winrt
             operator Windows::Foundation::Rect() noexcept { return Windows::Foundation::Rect(float(x), float(y), float(width), float(height)); }
         #endif
 
             // Comparison operators
             bool operator == (const Rectangle& r) const noexcept { return (x == r.x) && (y == r.y) && (width == r.width) && (height == r.height); }
-            bool operator == (const RECT& rct) const noexcept { return (x == rct.left) && (y == rct.top) && (width == (rct.right - rct.left)) && (height == (rct.bottom - rct.top)); }
-
             bool operator != (const Rectangle& r) const noexcept { return (x != r.x) || (y != r.y) || (width != r.width) || (height != r.height); }
+
+        #ifdef _WIN32
+            bool operator == (const RECT& rct) const noexcept { return (x == rct.left) && (y == rct.top) && (width == (rct.right - rct.left)) && (height == (rct.bottom - rct.top)); }
             bool operator != (const RECT& rct) const noexcept { return (x != rct.left) || (y != rct.top) || (width != (rct.right - rct.left)) || (height != (rct.bottom - rct.top)); }
 
             // Assignment operators
             Rectangle& operator=(_In_ const RECT& rct) noexcept { x = rct.left; y = rct.top; width = (rct.right - rct.left); height = (rct.bottom - rct.top); return *this; }
+        #endif
 
             // Rectangle operations
             Vector2 Location() const noexcept;
@@ -83,21 +90,27 @@ namespace DirectX
             bool Contains(long ix, long iy) const noexcept { return (x <= ix) && (ix < (x + width)) && (y <= iy) && (iy < (y + height)); }
             bool Contains(const Vector2& point) const noexcept;
             bool Contains(const Rectangle& r) const noexcept { return (x <= r.x) && ((r.x + r.width) <= (x + width)) && (y <= r.y) && ((r.y + r.height) <= (y + height)); }
+        #ifdef _WIN32
             bool Contains(const RECT& rct) const noexcept { return (x <= rct.left) && (rct.right <= (x + width)) && (y <= rct.top) && (rct.bottom <= (y + height)); }
+        #endif
 
             void Inflate(long horizAmount, long vertAmount) noexcept;
 
             bool Intersects(const Rectangle& r) const noexcept { return (r.x < (x + width)) && (x < (r.x + r.width)) && (r.y < (y + height)) && (y < (r.y + r.height)); }
+        #ifdef _WIN32
             bool Intersects(const RECT& rct) const noexcept { return (rct.left < (x + width)) && (x < rct.right) && (rct.top < (y + height)) && (y < rct.bottom); }
+        #endif
 
             void Offset(long ox, long oy) noexcept { x += ox; y += oy; }
 
             // Static functions
             static Rectangle Intersect(const Rectangle& ra, const Rectangle& rb) noexcept;
-            static RECT Intersect(const RECT& rcta, const RECT& rctb) noexcept;
-
             static Rectangle Union(const Rectangle& ra, const Rectangle& rb) noexcept;
+
+        #ifdef _WIN32
+            static RECT Intersect(const RECT& rcta, const RECT& rctb) noexcept;
             static RECT Union(const RECT& rcta, const RECT& rctb) noexcept;
+        #endif
         };
 
         //------------------------------------------------------------------------------
@@ -478,7 +491,7 @@ namespace DirectX
                              r1.x, r1.y, r1.z, r1.w,
                              r2.x, r2.y, r2.z, r2.w,
                              r3.x, r3.y, r3.z, r3.w) {}
-            Matrix(const XMFLOAT4X4& M) noexcept { memcpy_s(this, sizeof(float) * 16, &M, sizeof(XMFLOAT4X4)); }
+            Matrix(const XMFLOAT4X4& M) noexcept { memcpy(this, &M, sizeof(XMFLOAT4X4)); }
             Matrix(const XMFLOAT3X3& M) noexcept;
             Matrix(const XMFLOAT4X3& M) noexcept;
 
@@ -878,11 +891,13 @@ namespace DirectX
                 x(0.f), y(0.f), width(0.f), height(0.f), minDepth(0.f), maxDepth(1.f) {}
             constexpr Viewport(float ix, float iy, float iw, float ih, float iminz = 0.f, float imaxz = 1.f) noexcept :
                 x(ix), y(iy), width(iw), height(ih), minDepth(iminz), maxDepth(imaxz) {}
+        #ifdef _WIN32
             explicit Viewport(const RECT& rct) noexcept :
                 x(float(rct.left)), y(float(rct.top)),
                 width(float(rct.right - rct.left)),
                 height(float(rct.bottom - rct.top)),
                 minDepth(0.f), maxDepth(1.f) {}
+        #endif
 
         #if defined(__d3d11_h__) || defined(__d3d11_x_h__)
             // Direct3D 11 interop
@@ -918,8 +933,10 @@ namespace DirectX
             bool operator == (const Viewport& vp) const noexcept;
             bool operator != (const Viewport& vp) const noexcept;
 
+        #ifdef _WIN32
             // Assignment operators
             Viewport& operator= (const RECT& rct) noexcept;
+        #endif
 
             // Viewport operations
             float AspectRatio() const noexcept;
@@ -931,11 +948,13 @@ namespace DirectX
             void Unproject(const Vector3& p, const Matrix& proj, const Matrix& view, const Matrix& world, Vector3& result) const noexcept;
 
             // Static methods
+        #ifdef _WIN32
             static RECT __cdecl ComputeDisplayArea(DXGI_SCALING scaling, UINT backBufferWidth, UINT backBufferHeight, int outputWidth, int outputHeight) noexcept;
             static RECT __cdecl ComputeTitleSafeArea(UINT backBufferWidth, UINT backBufferHeight) noexcept;
+        #endif
         };
 
-    #include "SimpleMath.inl"
+    #include "simplemath.inl"
 
     } // namespace SimpleMath
 
@@ -1,4 +1,4 @@
-#include "SimpleMath.h"
+#include "simplemath.h"
 //-------------------------------------------------------------------------------------
 // SimpleMath.inl -- Simplified C++ Math wrapper for DirectXMath
 //
@@ -81,6 +81,7 @@ inline Rectangle Rectangle::Intersect(const Rectangle& ra, const Rectangle& rb)
     return result;
 }
 
+#ifdef _WIN32
 inline RECT Rectangle::Intersect(const RECT& rcta, const RECT& rctb) noexcept
 {
     long maxX = rcta.left > rctb.left ? rcta.left : rctb.left;
@@ -108,6 +109,7 @@ inline RECT Rectangle::Intersect(const RECT& rcta, const RECT& rctb) noexcept
 
     return result;
 }
+#endif
 
 inline Rectangle Rectangle::Union(const Rectangle& ra, const Rectangle& rb) noexcept
 {
@@ -131,6 +133,7 @@ inline Rectangle Rectangle::Union(const Rectangle& ra, const Rectangle& rb) noex
     return result;
 }
 
+#ifdef _WIN32
 inline RECT Rectangle::Union(const RECT& rcta, const RECT& rctb) noexcept
 {
     RECT result;
@@ -140,6 +143,7 @@ inline RECT Rectangle::Union(const RECT& rcta, const RECT& rctb) noexcept
     result.bottom = rcta.bottom > rctb.bottom ? rcta.bottom : rctb.bottom;
     return result;
 }
+#endif
 
 
 /****************************************************************************
@@ -3684,6 +3688,7 @@ inline bool Viewport::operator != (const Viewport& vp) const noexcept
 // Assignment operators
 //------------------------------------------------------------------------------
 
+#ifdef _WIN32
 inline Viewport& Viewport::operator= (const RECT& rct) noexcept
 {
     x = float(rct.left); y = float(rct.top);
@@ -3692,6 +3697,7 @@ inline Viewport& Viewport::operator= (const RECT& rct) noexcept
     minDepth = 0.f; maxDepth = 1.f;
     return *this;
 }
+#endif
 
 #if defined(__d3d11_h__) || defined(__d3d11_x_h__)
 inline Viewport& Viewport::operator= (const D3D11_VIEWPORT& vp) noexcept
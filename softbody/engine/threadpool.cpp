@@ -0,0 +1,82 @@
+#include "threadpool.h"
+
+#include <algorithm>
+
+namespace jobs
+{
+threadpool::threadpool(uint numthreads)
+{
+    uint const total = numthreads > 0 ? numthreads : std::max(1u, std::thread::hardware_concurrency());
+    workers.reserve(total - 1);
+    for (uint i = 1; i < total; ++i)
+        workers.emplace_back([this]() { workerloop(); });
+}
+
+threadpool::~threadpool()
+{
+    {
+        std::scoped_lock lock(mutex);
+        stop = true;
+    }
+
+    wake.notify_all();
+    for (auto& w : workers)
+        w.join();
+}
+
+void threadpool::parallelfor(uint count, std::function<void(uint)> const& f)
+{
+    // waking the workers costs more than a single iteration
+    if (workers.empty() || count < 2)
+    {
+        for (uint i = 0; i < count; ++i)
+            f(i);
+
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mutex);
+        job = &f;
+        jobcount = count;
+        next = 0;
+        busy = static_cast<uint>(workers.size());
+        generation++;
+    }
+
+    wake.notify_all();
+    work();
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [this]() { return busy == 0; });
+    job = nullptr;
+}
+
+void threadpool::work()
+{
+    for (uint i = next++; i < jobcount; i = next++)
+        (*job)(i);
+}
+
+void threadpool::workerloop()
+{
+    uint seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [this, seen]() { return stop || generation != seen; });
+            if (stop)
+                return;
+
+            seen = generation;
+        }
+
+        work();
+
+        std::scoped_lock lock(mutex);
+        if (--busy == 0)
+            done.notify_one();
+    }
+}
+}
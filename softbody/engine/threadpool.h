@@ -0,0 +1,50 @@
+#pragma once
+
+#include "stdx/stdxcore.h"
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace jobs
+{
+using stdx::uint;
+
+// fixed set of workers that share the iterations of a loop with the calling thread
+// which thread runs an iteration is not fixed, so iterations must not depend on each other
+class threadpool
+{
+public:
+    // numthreads counts the calling thread, 0 uses every hardware thread
+    threadpool(uint numthreads = 0);
+    ~threadpool();
+
+    threadpool(threadpool const&) = delete;
+    threadpool& operator=(threadpool const&) = delete;
+
+    uint numthreads() const { return static_cast<uint>(workers.size()) + 1; }
+
+    // calls f(i) for every i in [0, count) and returns when all of them are done
+    void parallelfor(uint count, std::function<void(uint)> const& f);
+
+private:
+    void work();
+    void workerloop();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+
+    std::function<void(uint)> const* job = nullptr;
+    uint jobcount = 0;
+    std::atomic<uint> next = 0;
+
+    // workers still on the current loop, a new loop bumps generation
+    uint busy = 0;
+    uint generation = 0;
+    bool stop = false;
+};
+}
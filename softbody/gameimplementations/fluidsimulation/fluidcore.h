@@ -10,6 +10,8 @@
 
 namespace fluid
 {
+using stdx::uint;
+
 enum class fieldsize
 {
 	bounded,
@@ -133,6 +135,18 @@ vecfield2<vd, l> jacobi2d(vecfield2<vd, l> const& x, vecfield2<vd, l> const& b,
 	return r;
 }
 
+// removes the divergent part of v, niters is the number of jacobi iterations used for the pressure solve
+template<uint l>
+void project(vecfield22<l>& v, uint niters = 4)
+{
+	// compute the pressure field, solving the linear equation : lap(p) = div(v)
+	vecfield21<l> p = {};
+	p = jacobi2d(p, divergence<l>(v), niters, 1.f, 4.f);
+
+	// per helmholtz-hodge decomposition, decompose divergent field into one without it and pressure gradient
+	v = v - gradient(p);
+}
+
 template<uint vd, uint l>
 vecfield2<vd, l> advect2d(vecfield2<vd, l> const& a, vecfield22<l> const& v, float dt)
 {
@@ -136,12 +136,7 @@ private:
         v = advect2d(v, v, dt);
         v = diffuse({}, v, dt, 0.5f);  // this new field has divergence
 
-        // compute the pressure field, solving the linear equation : lap(p) = div(v)
-        vecfield21<l> p = {};
-        p = jacobi2d(p, divergence<l>(v), 4, 1.f, 4.f);
-
-        // per helmholtz-hodge decomposition, decompose divergent field into one without it and pressure gradient
-        v = v - gradient(p);  // this is the divergence free field
+        project(v);  // this is the divergence free field
         bound(v, -1.f);
 
         // diffuse dyes
@@ -2,6 +2,7 @@
 #include "stdx/stdx.h"
 #include "engine/engineutils.h"
 #include "engine/graphics/body.h"
+#include "engine/geometry/geoutils.h"
 #include "engine/graphics/globalresources.h"
 
 #include "gameutils.h"
@@ -10,7 +11,6 @@
 #include <ranges>
 #include <algorithm>
 #include <functional>
-#include <unordered_set>
 
 namespace game_creator
 {
@@ -22,55 +22,15 @@ namespace gameparams
     constexpr float speed = 10.f;
     constexpr uint numballs = 80;
     constexpr float ballradius = 2.5f;
-}
-
-geometry::ffddata createffddata(geometry::shapeffd_c auto shape)
-{ 
-    auto const center = shape.gcenter();
-    shape.scenter(vector3::Zero);
-    shape.generate_triangles();
-    return { center, shape.triangles() };
-}
-
-std::vector<vector3> fillwithspheres(geometry::aabb const& box, uint count, float radius)
-{
-    std::unordered_set<uint> occupied;
-    std::vector<vector3> spheres;
-
-    auto const roomspan = (box.span() - stdx::tolerance<vector3>);
-
-    assert(roomspan.x > 0.f);
-    assert(roomspan.y > 0.f);
-    assert(roomspan.z > 0.f);
-
-    uint const degree = static_cast<uint>(std::ceil(std::cbrt(count))) - 1;
-    uint const numcells = (degree + 1) * (degree + 1) * (degree + 1);
-    float const gridvol = numcells * 8 * (radius * radius * radius);
-
-    // find the size of largest cube that can be fit into box
-    float const cubelen = std::min({ roomspan.x, roomspan.y, roomspan.z });
-    float const celld = cubelen / (degree + 1);
-    float const cellr = celld / 2.f;;
+    constexpr auto weights = beziermaths::weightstorage::none;
 
-    // check if this box can contain all cells
-    assert(cubelen * cubelen * cubelen > gridvol);
+    // static geometry is collided through a distance field with cells this big
+    constexpr float levelcellsize = 1.f;
 
-    vector3 const gridorigin = { box.center() - vector3(cubelen / 2.f) };
-    for (auto i : std::ranges::iota_view{ 0u,  count })
-    {
-        static auto& re = engineutils::getrandomengine();
-        static std::uniform_int_distribution<uint> distvoxel(0u, numcells - 1);
-
-        uint emptycell = 0;
-        while (occupied.find(emptycell) != occupied.end()) emptycell = distvoxel(re);
-
-        occupied.insert(emptycell);
-
-        auto const thecell = stdx::grididx<2>::from1d(degree, emptycell);
-        spheres.emplace_back((vector3(thecell[0] * celld, thecell[2] * celld, thecell[1] * celld) + vector3(cellr)) + gridorigin);
-    }
-
-    return spheres;
+    // the broadphases generate the same pairs
+    // the grid suits many similar sized bodies, sort and sweep few of them and the tree bodies of mixed sizes
+    enum class broadphases { grid, sweepandprune, tree };
+    constexpr auto broadphase = broadphases::grid;
 }
 
 using namespace DirectX;
@@ -86,22 +46,62 @@ void soft_body::update(float dt)
 {
     game_base::update(dt);
 
-    auto const& roomaabb = boxes[0]->bbox();
-
     for (uint i = 0; i < gameparams::numballs; ++i)
-        for (uint j = i + 1; j < gameparams::numballs; ++j)
-            balls[i].get().resolve_collision(balls[j].get(), dt);
+        broadphase->update(i, balls[i]->sweptbox(dt));
 
-    for (uint i = 0; i < gameparams::numballs; ++i)
-        balls[i].get().resolve_collision_interior(roomaabb, dt);
+    // the cache is only touched here, the pairs of a color touch different balls and manifolds
+    auto const& pairs = broadphase->findpairs();
+    manifolds.clear();
+    for (auto const& pair : pairs)
+        manifolds.push_back(&contacts.touch(pair).first);
 
-    for (auto b : stdx::makejoin<gfx::bodyinterface>(balls, reflines)) b->update(dt);
+    coloring.build(pairs);
+    for (uint c = 0; c < coloring.numcolors(); ++c)
+    {
+        auto const batch = coloring.color(c);
+        pool.parallelfor(batch.size(), [&](uint i)
+        {
+            auto const [l, r] = pairs[batch[i]];
+            balls[l].get().resolve_collision(balls[r].get(), dt, *manifolds[batch[i]]);
+        });
+    }
+
+    contacts.endframe();
+
+    pool.parallelfor(gameparams::numballs, [&](uint i) { balls[i].get().resolve_collision(level, dt); });
+
+    // balls fast enough to skip through each other or the walls in this step only travel up to their time of impact
+    for (uint c = 0; c < coloring.numcolors(); ++c)
+    {
+        auto const batch = coloring.color(c);
+        pool.parallelfor(batch.size(), [&](uint i)
+        {
+            auto const [l, r] = pairs[batch[i]];
+            if (auto const toi = balls[l].get().timeofimpact(balls[r].get(), dt))
+            {
+                balls[l].get().limitstep(*toi);
+                balls[r].get().limitstep(*toi);
+            }
+        });
+    }
+
+    pool.parallelfor(gameparams::numballs, [&](uint i)
+    {
+        if (auto const toi = balls[i].get().timeofimpact(level, dt))
+            balls[i].get().limitstep(*toi);
+    });
+
+    // the balls step together, their meshes deform in parallel(reflines refer to the balls, so they have nothing to update)
+    world.step(dt);
+    pool.parallelfor(world.size(), [this](uint i) { world.deform(i); });
 
     gfx::globalresources::get().view().proj = camera.GetProjectionMatrix(XM_PI / 3.0f);
     gfx::globalresources::get().cbuffer().data().campos = camera.GetCurrentPosition();
     gfx::globalresources::get().cbuffer().updateresource();
 }
 
+void soft_body::interpolate(float t) { world.interpolate(t); }
+
 void soft_body::render(float dt)
 {
     for (auto b : stdx::makejoin<gfx::bodyinterface>(boxes, balls)) b->render(dt, { wireframe_toggle });
@@ -148,17 +148,36 @@ gfx::resourcelist soft_body::load_assets_and_geometry()
     boxes.emplace_back(cube{ {vector3{0.f, 0.f, 0.f}}, vector3{40.f} }, &cube::vertices_flipped, &cube::instancedata, bodyparams{ "instanced" });
     
     auto const& roomaabb = boxes[0]->bbox();
+
+    // a cell of margin around the room so the walls have a gradient on both sides
+    level = geometry::distancefield{ { roomaabb.min_pt - vector3{ gameparams::levelcellsize }, roomaabb.max_pt + vector3{ gameparams::levelcellsize } }, gameparams::levelcellsize };
+    level.addroom(roomaabb);
+
     static auto& re = engineutils::getrandomengine();
     static std::uniform_real_distribution<float> distvelocity(-1.f, 1.f);
 
+    // all balls deform the same mesh, so they share its rest state and bernstein weights
+    auto const balldata = geometry::createffddata(sphere{ vector3::Zero, gameparams::ballradius }, gameparams::weights);
+
     static const auto basemat_ball = gfx::globalresources::get().mat("ball");
-    for (auto const& center : fillwithspheres(roomaabb, gameparams::numballs, gameparams::ballradius))
+    for (auto const& center : geoutils::fillwithspheres(roomaabb, gameparams::numballs, gameparams::ballradius))
     {
         auto const velocity = vector3{ distvelocity(re), distvelocity(re), distvelocity(re) }.Normalized() * gameparams::speed;
-        balls.emplace_back(ffd_object(createffddata(sphere{ center, gameparams::ballradius })), bodyparams{ "wireframe", gfx::generaterandom_matcolor(basemat_ball) });
+        balls.emplace_back(world.add({ center, balldata.mesh }), bodyparams{ "wireframe", gfx::generaterandom_matcolor(basemat_ball) });
         balls.back()->svelocity(velocity);
     }
 
+    // grid cells are one ball across, so a ball only overlaps the few cells around it
+    if constexpr (gameparams::broadphase == gameparams::broadphases::sweepandprune)
+        broadphase = std::make_unique<collision::sweep_and_prune>();
+    else if constexpr (gameparams::broadphase == gameparams::broadphases::tree)
+        broadphase = std::make_unique<collision::aabbtree>(gameparams::ballradius * 0.2f);
+    else
+        broadphase = std::make_unique<collision::spatial_partition>(gameparams::ballradius * 2.f, roomaabb);
+
+    for (auto const& b : balls)
+        broadphase->insert(b->bboxworld());
+
     // ensure balls container will no longer be modified, since visualizations take references to objects in container
     for (auto const& b : balls)
     {
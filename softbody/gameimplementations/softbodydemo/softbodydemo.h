@@ -2,6 +2,8 @@
 
 #include "gamebase.h"
 #include "engine/geometry/ffd.h"
+#include "engine/physics/collision.h"
+#include "engine/threadpool.h"
 #include "engine/graphics/gfxcore.h"
 
 import shapes;
@@ -25,6 +27,7 @@ public:
 
 	void update(float dt) override;
 	void render(float dt) override;
+	void interpolate(float t) override;
 	
 	gfx::resourcelist load_assets_and_geometry() override;
 
@@ -34,8 +37,24 @@ private:
 	bool wireframe_toggle = false;
 	bool debugviz_toggle = false;
 
+	// proxy i of the broadphase is balls[i]
+	std::unique_ptr<collision::broadphase> broadphase;
+
+	// contacts of the colliding pairs, kept across frames
+	collision::paircache<geometry::contactmanifold> contacts;
+
+	// pairs are resolved a color at a time, the pairs of a color in parallel
+	collision::paircoloring coloring;
+	std::vector<geometry::contactmanifold*> manifolds;
+	jobs::threadpool pool;
+
+	// the state of the balls, balls hold handles into it
+	geometry::ffd_world world;
 	std::vector<gfx::body_dynamic<geometry::ffd_object>> balls;
 	std::vector<gfx::body_static<geometry::cube>> boxes;
+
+	// the static geometry balls collide with, built from boxes
+	geometry::distancefield level;
 	std::vector<gfx::body_dynamic<geometry::ffd_object const&, gfx::topology::line>> reflines;
 	std::vector<gfx::body_static<geometry::ffd_object const&, gfx::topology::line>> refstaticlines;
 };
\ No newline at end of file
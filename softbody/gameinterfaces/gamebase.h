@@ -17,6 +17,9 @@ public:
 	virtual void update(float dt) { updateview(dt); };
 	virtual void render(float dt) = 0;
 
+	// updates run at a fixed rate, t is how far the frame about to be rendered is between the last two of them
+	virtual void interpolate(float t) {};
+
 	virtual void on_key_down(unsigned key) { camera.OnKeyDown(key); };
 	virtual void on_key_up(unsigned key) { camera.OnKeyUp(key); };
 
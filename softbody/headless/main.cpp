@@ -0,0 +1,215 @@
+#include "stdx/stdx.h"
+#include "engine/engineutils.h"
+#include "engine/simd.h"
+#include "engine/threadpool.h"
+#include "engine/geometry/ffd.h"
+#include "engine/geometry/geocore.h"
+#include "engine/geometry/geoutils.h"
+#include "engine/geometry/distancefield.h"
+#include "engine/physics/collision.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+import shapes;
+
+// steps the soft body simulation without a window or a gpu, so that it can be profiled on headless machines
+// usage : softbody_headless [numbodies] [numframes] [dt] [weights(none, separable or tensor)] [broadphase(grid, sap or tree)] [threads(0 for all)] [ccd(on or off)]
+
+namespace headlessparams
+{
+    constexpr float speed = 10.f;
+    constexpr float ballradius = 2.5f;
+    constexpr float roomlen = 40.f;
+    constexpr float levelcellsize = 1.f;
+}
+
+enum class phase : stdx::uint
+{
+    collision,
+    level,
+    ccd,
+    update,
+    num
+};
+
+char const* phasenames[stdx::uint(phase::num)] = { "collision", "level", "ccd", "update" };
+
+struct phasetimer
+{
+    using clock = std::chrono::steady_clock;
+
+    void begin() { start = clock::now(); }
+    void end(phase p) { totals[stdx::uint(p)] += std::chrono::duration<double, std::milli>(clock::now() - start).count(); }
+
+    clock::time_point start;
+    std::array<double, stdx::uint(phase::num)> totals = {};
+};
+
+int main(int argc, char** argv)
+{
+    using stdx::uint;
+    using geometry::ffd_object;
+
+    uint const numbodies = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 80;
+    uint const numframes = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 600;
+    float const dt = argc > 3 ? std::strtof(argv[3], nullptr) : 1.f / 60.f;
+    std::string const weightsarg = argc > 4 ? argv[4] : "none";
+    std::string const broadphasearg = argc > 5 ? argv[5] : "grid";
+    uint const numthreads = argc > 6 ? std::strtoul(argv[6], nullptr, 10) : 1;
+    std::string const ccdarg = argc > 7 ? argv[7] : "on";
+
+    auto const storage = weightsarg == "separable" ? beziermaths::weightstorage::separable : (weightsarg == "tensor" ? beziermaths::weightstorage::tensor : beziermaths::weightstorage::none);
+    if (numbodies == 0 || numframes == 0 || dt <= 0.f || (storage == beziermaths::weightstorage::none && weightsarg != "none") || (broadphasearg != "grid" && broadphasearg != "sap" && broadphasearg != "tree") || (ccdarg != "on" && ccdarg != "off"))
+    {
+        std::printf("usage : softbody_headless [numbodies] [numframes] [dt] [weights(none, separable or tensor)] [broadphase(grid, sap or tree)] [threads(0 for all)] [ccd(on or off)]\n");
+        return 1;
+    }
+
+    // grow the room when it cannot hold the requested number of balls
+    float const cellsperside = std::ceil(std::cbrt(static_cast<float>(numbodies)));
+    float const roomlen = std::max(headlessparams::roomlen, (cellsperside + 1.f) * 2.f * headlessparams::ballradius);
+    geometry::aabb const room{ vector3{ -roomlen / 2.f }, vector3{ roomlen / 2.f } };
+
+    // the walls of the room as a distance field, with a cell of margin so they have a gradient on both sides
+    geometry::distancefield level{ { room.min_pt - vector3{ headlessparams::levelcellsize }, room.max_pt + vector3{ headlessparams::levelcellsize } }, headlessparams::levelcellsize };
+    level.addroom(room);
+
+    auto& re = engineutils::getrandomengine();
+    re.seed(0);
+    std::uniform_real_distribution<float> distvelocity(-1.f, 1.f);
+
+    auto const setupstart = phasetimer::clock::now();
+
+    // every body deforms the same sphere, so one mesh and weight cache serves all of them
+    auto const balldata = geometry::createffddata(geometry::sphere{ vector3::Zero, headlessparams::ballradius }, storage);
+
+    // bodies[i] is a handle to body i of world
+    geometry::ffd_world world;
+    std::vector<ffd_object> bodies;
+    bodies.reserve(numbodies);
+    for (auto const& center : geoutils::fillwithspheres(room, numbodies, headlessparams::ballradius))
+    {
+        bodies.push_back(world.add({ center, balldata.mesh }));
+        bodies.back().svelocity(vector3{ distvelocity(re), distvelocity(re), distvelocity(re) }.Normalized() * headlessparams::speed);
+    }
+
+    // proxy i is bodies[i]
+    std::unique_ptr<collision::broadphase> broadphase;
+    if (broadphasearg == "sap")
+        broadphase = std::make_unique<collision::sweep_and_prune>();
+    else if (broadphasearg == "tree")
+        broadphase = std::make_unique<collision::aabbtree>(headlessparams::ballradius * 0.2f);
+    else
+        broadphase = std::make_unique<collision::spatial_partition>(headlessparams::ballradius * 2.f, room);
+
+    // with ccd the boxes cover the travel of the step, so the pairs include the bodies that may meet during it
+    bool const ccd = ccdarg == "on";
+    auto const broadbox = [ccd, dt](ffd_object const& b) { return ccd ? b.sweptbox(dt) : b.bboxworld(); };
+    for (auto const& b : bodies)
+        broadphase->insert(broadbox(b));
+
+    double const setupms = std::chrono::duration<double, std::milli>(phasetimer::clock::now() - setupstart).count();
+
+    collision::paircache<geometry::contactmanifold> contacts;
+    collision::paircoloring coloring;
+    std::vector<geometry::contactmanifold*> manifolds;
+    jobs::threadpool pool(numthreads);
+
+    phasetimer timer;
+    std::size_t numpairs = 0, numreused = 0, numcolors = 0;
+    std::atomic<std::size_t> numlimited = 0;
+    for (uint frame = 0; frame < numframes; ++frame)
+    {
+        timer.begin();
+        for (uint i = 0; i < numbodies; ++i)
+            broadphase->update(i, broadbox(bodies[i]));
+
+        // the cache is only touched here, the pairs of a color touch different bodies and manifolds
+        auto const& pairs = broadphase->findpairs();
+        manifolds.clear();
+        for (auto const& pair : pairs)
+            manifolds.push_back(&contacts.touch(pair).first);
+
+        coloring.build(pairs);
+        for (uint c = 0; c < coloring.numcolors(); ++c)
+        {
+            auto const batch = coloring.color(c);
+            pool.parallelfor(batch.size(), [&](uint i)
+            {
+                auto const [l, r] = pairs[batch[i]];
+                bodies[l].resolve_collision(bodies[r], dt, *manifolds[batch[i]]);
+            });
+        }
+
+        for (auto const* manifold : manifolds)
+            numreused += manifold->reused;
+
+        contacts.endframe();
+        numpairs += broadphase->numpairs();
+        numcolors += coloring.numcolors();
+        timer.end(phase::collision);
+
+        timer.begin();
+        pool.parallelfor(numbodies, [&](uint i) { bodies[i].resolve_collision(level, dt); });
+        timer.end(phase::level);
+
+        // bodies fast enough to skip through each other or the walls in this step only travel up to their time of impact
+        timer.begin();
+        if (ccd)
+        {
+            for (uint c = 0; c < coloring.numcolors(); ++c)
+            {
+                auto const batch = coloring.color(c);
+                pool.parallelfor(batch.size(), [&](uint i)
+                {
+                    auto const [l, r] = pairs[batch[i]];
+                    if (auto const toi = bodies[l].timeofimpact(bodies[r], dt))
+                    {
+                        bodies[l].limitstep(*toi);
+                        bodies[r].limitstep(*toi);
+                        numlimited++;
+                    }
+                });
+            }
+
+            pool.parallelfor(numbodies, [&](uint i)
+            {
+                if (auto const toi = bodies[i].timeofimpact(level, dt))
+                {
+                    bodies[i].limitstep(*toi);
+                    numlimited++;
+                }
+            });
+        }
+        timer.end(phase::ccd);
+
+        timer.begin();
+        world.step(dt);
+        pool.parallelfor(numbodies, [&](uint i) { world.deform(i); });
+        timer.end(phase::update);
+    }
+
+    double total = 0.0;
+    for (auto const t : timer.totals) total += t;
+
+    std::printf("bodies %zu, frames %zu, dt %.5fs, verts per body %zu, tris per body %zu, setup %.2fms\n", numbodies, numframes, dt, bodies[0].uniquevertices().size(), bodies[0].indices().size() / 3, setupms);
+    std::printf("weights %s, shared cache %.1fkb, shared mesh %.1fkb, level field %.1fkb, isa %s\n", weightsarg.c_str(), balldata.mesh->weights.memory() / 1024.0, balldata.mesh->memory() / 1024.0, level.memory() / 1024.0, simd::name(simd::active()));
+    std::printf("broadphase %s, pairs per frame %.1f, contacts reused %.1f%%\n", broadphasearg.c_str(), double(numpairs) / numframes, numpairs ? 100.0 * numreused / numpairs : 0.0);
+    std::printf("threads %zu, pair colors per frame %.1f\n", pool.numthreads(), double(numcolors) / numframes);
+    std::printf("ccd %s, steps limited by a time of impact per frame %.2f\n", ccdarg.c_str(), double(numlimited) / numframes);
+    std::printf("%-12s %12s %12s %8s\n", "phase", "total(ms)", "frame(ms)", "share");
+    for (uint i = 0; i < uint(phase::num); ++i)
+        std::printf("%-12s %12.2f %12.4f %7.1f%%\n", phasenames[i], timer.totals[i], timer.totals[i] / numframes, 100.0 * timer.totals[i] / total);
+    std::printf("%-12s %12.2f %12.4f\n", "total", total, total / numframes);
+
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "stdx/stdxcore.h"
+#include "engine/core.h"
+#include "engine/simd.h"
+#include "engine/geometry/tritri.h"
+#include "engine/geometry/aabbkernels.h"
+#include "engine/physics/springkernels.h"
+
+#include <bit>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <optional>
+
+import spring;
+
+// checks the avx2 kernel tables of the core against their scalar tables and exits with 1 when one of them disagrees
+// the avx2 tables contract with fma, so the scalar table is the reference and not a double precision one
+// usage : softbody_kernelcheck
+
+namespace
+{
+using stdx::uint;
+
+constexpr uint samples = 1 << 16;
+
+// cases are results compared, differing the ones that are not bit identical
+struct check
+{
+    std::string name;
+    uint cases = 0;
+    uint differing = 0;
+
+    // differing results the check tolerates
+    uint allowed = 0;
+
+    // writes past the room the kernels are allowed to use, never tolerated
+    uint guardswritten = 0;
+
+    // only for kernels with float results, the largest absolute difference and the one the check tolerates
+    std::optional<double> maxdiff;
+    double bound = 0.0;
+
+    bool passed() const { return differing <= allowed && guardswritten == 0 && (!maxdiff || *maxdiff <= bound); }
+};
+
+// random pairs rarely come near a tie and have to agree everywhere
+// the near coplanar ones put the second triangle within 1e-3 of the plane of the first and mostly within the snap to it,
+// where fma rounding can decide a vertex is on the plane, one case in a thousand may differ(17 of 36997 measured)
+check checktritri(bool nearcoplanar)
+{
+    using namespace geometry::tritri;
+
+    std::mt19937 re(11);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::uniform_real_distribution<float> spread(-0.5f, 1.5f);
+    std::uniform_real_distribution<float> exponent(-8.f, -3.f);
+    std::uniform_int_distribution<uint> lanes(1, width);
+
+    check res{ nearcoplanar ? "tritri(near coplanar)" : "tritri(random)" };
+    for (uint b = 0; b < samples / width; ++b)
+    {
+        vector3 const p[3] = { { unit(re), unit(re), unit(re) }, { unit(re), unit(re), unit(re) }, { unit(re), unit(re), unit(re) } };
+        vector3 const normal = (p[1] - p[0]).Cross(p[2] - p[0]).Normalized();
+        float const tri[9] = { p[0].x, p[0].y, p[0].z, p[1].x, p[1].y, p[1].z, p[2].x, p[2].y, p[2].z };
+
+        // every lane is filled, the ones from count on hold data the kernels have to ignore
+        candidates c;
+        c.count = lanes(re);
+        for (uint i = 0; i < width; ++i)
+            for (uint v = 0; v < 3; ++v)
+            {
+                float const offset = (unit(re) < 0.5f ? -1.f : 1.f) * std::pow(10.f, exponent(re));
+                vector3 const q = nearcoplanar ? p[0] + (p[1] - p[0]) * spread(re) + (p[2] - p[0]) * spread(re) + normal * offset : vector3{ unit(re), unit(re), unit(re) };
+                c.coords[v][0][i] = q.x, c.coords[v][1][i] = q.y, c.coords[v][2][i] = q.z;
+            }
+
+        res.cases += c.count;
+        res.differing += std::popcount(scalar().overlaps(tri, c) ^ avx2().overlaps(tri, c));
+    }
+
+    if (nearcoplanar) res.allowed = res.cases / 1000;
+    return res;
+}
+
+// ranges start at an offset and are not a whole number of registers long, corners on a coarse grid so many boxes touch
+// the avx2 overlaps writes whole registers, out gets a guard past the room the kernels are allowed to use
+// a range differs when its count or any index does, every index of it is counted
+check checkaabboverlaps()
+{
+    using namespace geometry::aabbkernels;
+
+    std::mt19937 re(13);
+    std::uniform_int_distribution<int> cell(0, 16);
+    std::uniform_int_distribution<uint> extent(0, 4);
+    std::uniform_int_distribution<uint> firsts(0, 2 * width - 1);
+    std::uniform_int_distribution<uint> counts(0, 12 * width);
+
+    uint const guard = width;
+    uint const sentinel = std::numeric_limits<uint>::max();
+    check res{ "aabb overlaps" };
+    while (res.cases < samples)
+    {
+        uint const first = firsts(re);
+        uint count = counts(re);
+        if (count % width == 0) ++count;
+
+        // min xyz then max xyz
+        auto const randombox = [&](float* box)
+        {
+            for (uint c = 0; c < 3; ++c)
+            {
+                box[c] = float(cell(re)) / 16.f;
+                box[c + 3] = box[c] + float(extent(re)) / 16.f;
+            }
+        };
+
+        std::vector<float> coords[6];
+        for (auto& c : coords) c.resize(first + count);
+        for (uint i = 0; i < first + count; ++i)
+        {
+            float box[6];
+            randombox(box);
+            for (uint c = 0; c < 6; ++c) coords[c][i] = box[c];
+        }
+
+        float query[6];
+        randombox(query);
+
+        boxrange const range{ { coords[0].data(), coords[1].data(), coords[2].data() }, { coords[3].data(), coords[4].data(), coords[5].data() }, first, count };
+        uint const room = (count + width - 1) / width * width;
+        std::vector<uint> ref(room + guard, sentinel), out(room + guard, sentinel);
+        uint const numref = scalar().overlaps(query, range, ref.data());
+        uint const num = avx2().overlaps(query, range, out.data());
+
+        bool const same = num == numref && std::equal(ref.begin(), ref.begin() + numref, out.begin());
+        res.cases += count;
+        res.differing += same ? 0 : count;
+        res.guardswritten += uint(std::count_if(out.begin() + room, out.end(), [=](uint i) { return i != sentinel; }));
+    }
+
+    return res;
+}
+
+// triangles picked from an offset into tris, the last register partial, out gets a guard past count
+// min and max do not round, the boxes have to be identical
+check checkaabbfromtriangles()
+{
+    using namespace geometry::aabbkernels;
+
+    std::mt19937 re(17);
+    std::uniform_real_distribution<float> signedunit(-1.f, 1.f);
+    std::uniform_int_distribution<uint> firsts(0, 2 * width - 1);
+    std::uniform_int_distribution<uint> counts(1, 12 * width);
+
+    uint const numverts = 256;
+    std::vector<float> positions(numverts * 3);
+    for (auto& p : positions) p = signedunit(re);
+
+    std::uniform_int_distribution<uint> vert(0, numverts - 1);
+    std::vector<uint> indices(3 * numverts);
+    for (auto& i : indices) i = vert(re);
+
+    std::uniform_int_distribution<uint> tri(0, numverts - 1);
+    uint const guard = width;
+    float const sentinel = -1234.f;
+    check res{ "aabb fromtriangles" };
+    while (res.cases < samples)
+    {
+        uint const first = firsts(re);
+        uint count = counts(re);
+        if (count % width == 0) ++count;
+
+        std::vector<uint> tris(first + count);
+        for (auto& t : tris) t = tri(re) * 3;
+
+        std::vector<float> ref[6], out[6];
+        for (uint c = 0; c < 6; ++c) ref[c].assign(count + guard, sentinel), out[c].assign(count + guard, sentinel);
+
+        scalar().fromtriangles(positions.data(), indices.data(), tris.data() + first, count, { { ref[0].data(), ref[1].data(), ref[2].data() }, { ref[3].data(), ref[4].data(), ref[5].data() } });
+        avx2().fromtriangles(positions.data(), indices.data(), tris.data() + first, count, { { out[0].data(), out[1].data(), out[2].data() }, { out[3].data(), out[4].data(), out[5].data() } });
+
+        for (uint i = 0; i < count + guard; ++i)
+        {
+            bool same = true;
+            for (uint c = 0; c < 6; ++c) same = same && ref[c][i] == out[c][i];
+            if (i < count) res.differing += same ? 0 : 1;
+            else res.guardswritten += same ? 0 : 1;
+        }
+        res.cases += count;
+    }
+
+    return res;
+}
+
+// one step of the transitions ffd_object uses for its springs, over ranges that start at an offset and are not a whole number of registers long
+// the floats around the range are guards the kernels must not touch
+// fma rounds the results differently, so any of them may differ but by at most 1e-6, 2 ulps of the states below 8 it steps(4.8e-7 measured)
+check checkspringstep()
+{
+    using namespace physx::springkernels;
+
+    std::mt19937 re(19);
+    std::uniform_real_distribution<float> signedunit(-1.f, 1.f);
+    std::uniform_int_distribution<uint> firsts(0, 2 * width - 1);
+    std::uniform_int_distribution<uint> counts(1, 12 * width);
+
+    std::vector<transition> transitions;
+    for (float const eta : { 0.1f, 0.5f, 1.f })
+        for (float const dt : { 1.f / 240.f, 1.f / 60.f, 1.f / 15.f })
+            transitions.push_back(physx::spring{ eta }.transition(dt));
+
+    uint const guard = width;
+    float const sentinel = -1234.f;
+    check res{ "spring step" };
+    res.maxdiff = 0.0, res.bound = 1e-6;
+    for (uint k = 0; res.cases < samples; ++k)
+    {
+        uint const first = firsts(re);
+        uint count = counts(re);
+        if (count % width == 0) ++count;
+
+        std::vector<float> rest(first + count + guard), points(first + count + guard, sentinel), velocities(first + count + guard, sentinel);
+        for (uint i = first; i < first + count; ++i)
+            rest[i] = signedunit(re), points[i] = rest[i] + 0.1f * signedunit(re), velocities[i] = 5.f * signedunit(re);
+
+        auto refpoints = points, refvelocities = velocities;
+        auto const& t = transitions[k % transitions.size()];
+        scalar().step(refpoints.data() + first, rest.data() + first, refvelocities.data() + first, count, t);
+        avx2().step(points.data() + first, rest.data() + first, velocities.data() + first, count, t);
+
+        for (uint i = 0; i < points.size(); ++i)
+        {
+            if (i < first || i >= first + count)
+            {
+                res.guardswritten += (points[i] != sentinel ? 1 : 0) + (velocities[i] != sentinel ? 1 : 0);
+                continue;
+            }
+
+            res.differing += (points[i] != refpoints[i] ? 1 : 0) + (velocities[i] != refvelocities[i] ? 1 : 0);
+            res.maxdiff = std::max({ *res.maxdiff, double(std::fabs(points[i] - refpoints[i])), double(std::fabs(velocities[i] - refvelocities[i])) });
+        }
+        res.cases += 2 * count;
+    }
+
+    res.allowed = res.cases;
+    return res;
+}
+}
+
+int main()
+{
+    using stdx::uint;
+
+    if (simd::detect() < simd::isa::avx2)
+    {
+        std::printf("isa %s, no avx2 tables to check\n", simd::name(simd::detect()));
+        return 0;
+    }
+
+    std::vector<check> const checks = { checktritri(false), checktritri(true), checkaabboverlaps(), checkaabbfromtriangles(), checkspringstep() };
+
+    bool passed = true;
+    std::printf("%-26s %10s %10s %10s %10s %14s %10s %8s\n", "kernel", "cases", "differing", "allowed", "guards", "max abs diff", "bound", "result");
+    for (auto const& c : checks)
+    {
+        if (c.maxdiff) std::printf("%-26s %10zu %10zu %10zu %10zu %14.3e %10.1e %8s\n", c.name.c_str(), c.cases, c.differing, c.allowed, c.guardswritten, *c.maxdiff, c.bound, c.passed() ? "ok" : "failed");
+        else std::printf("%-26s %10zu %10zu %10zu %10zu %14s %10s %8s\n", c.name.c_str(), c.cases, c.differing, c.allowed, c.guardswritten, "-", "-", c.passed() ? "ok" : "failed");
+        passed = passed && c.passed();
+    }
+
+    return passed ? 0 : 1;
+}
@@ -160,8 +160,7 @@ constexpr auto binaryop(l_t&& a, r_t&& b, f_t f)
 }
 
 // type, lerp degree, current dimension being lerped
-template<typename t, uint n, uint d = 0>
-requires (n >= 0 && arithmetic_c<t>)
+template<arithmetic_c t, uint n, uint d = 0>
 struct nlerp
 {
 	static constexpr t lerp(std::array<t, stdx::pown(2, n - d + 1)> const& data, std::array<float, n + 1> alpha)
@@ -173,8 +172,8 @@ struct nlerp
 	}
 };
 
-template<typename t, uint n, uint d>
-requires (n >= 0 && d == n + 1 && arithmetic_c<t>)
+template<arithmetic_c t, uint n, uint d>
+requires (d == n + 1)
 struct nlerp<t, n, d>
 {
 	static constexpr t lerp(std::array<t, 1> const& data, std::array<float, n + 1> alpha) { return data[0]; }
@@ -283,13 +282,13 @@ struct joiniter
 	using idx_t = uint;
 	using join_t = join<t, args_t...>;
 
-	joiniter(join_t* _join, uint _idx) : join(_join), idx(_idx) {}
-	t* operator*() { return join->get(idx); }
-	bool operator!=(joiniter const& rhs) const { return idx != rhs.idx || join != rhs.join; }
+	joiniter(join_t* _join, uint _idx) : idx(_idx), owner(_join) {}
+	t* operator*() { return owner->get(idx); }
+	bool operator!=(joiniter const& rhs) const { return idx != rhs.idx || owner != rhs.owner; }
 	joiniter& operator++() { idx++; return *this; }
 
 	idx_t idx;
-	join_t* join;
+	join_t* owner;
 };
 
 template<typename t, indexablecontainer_c... args_t>
@@ -297,7 +296,7 @@ struct join
 {
 private:
 	using iter_t = joiniter<t, args_t...>;
-	friend struct iter_t;
+	friend iter_t;
 	static constexpr uint mysize = sizeof...(args_t);
 
 public:
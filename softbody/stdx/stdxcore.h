@@ -4,10 +4,12 @@
 #include <concepts>
 #include <type_traits>
 
-using uint = std::size_t;
-
 namespace stdx
 {
+// the size type of the project, code outside stdx brings it in with using stdx::uint
+// off windows sys/types.h declares ::uint as unsigned int, so the global namespace cannot hold it there
+using uint = std::size_t;
+
 template <typename t> concept uint_c = std::convertible_to<t, uint>;
 
 template <typename t>
@@ -42,4 +44,9 @@ concept indexablecontainer_c = requires(t v)
 template <typename t, typename u>
 concept samedecay_c = std::same_as<std::decay_t<t>, std::decay_t<u>>;
 
-}
\ No newline at end of file
+}
+
+#ifdef _WIN32
+// the d3d12 demo only builds on windows and uses it from the global namespace
+using stdx::uint;
+#endif
@@ -62,7 +62,7 @@ using vecui3 = vecui<2>;
 
 namespace std
 {
-	template <typename t, uint d>
+	template <typename t, stdx::uint d>
 	class numeric_limits<stdx::vec<d, t>>
 	{
 		static constexpr stdx::vec<d, t> min() noexcept { return t().fill(std::numeric_limits<stdx::containervalue_t<stdx::vec<d, t>>>::min()); }